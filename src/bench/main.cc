@@ -0,0 +1,6 @@
+#include "../inc/bench/DoublyLinkedList.hh"
+#include "../inc/bench/LruCache.hh"
+#include "../inc/bench/CompressedDoublyLinkedList.hh"
+#include "../inc/bench/IntrusiveDoublyLinkedList.hh"
+
+BENCHMARK_MAIN();
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "DoublyLinkedList.hh"
+
+/**
+ * @brief capacity bounded doubly linked list for sliding windows
+ *
+ * @tparam T value type
+ * @tparam S capacity type = unsigned
+ *
+ * All capacity nodes are allocated once, as a ring of slots. The list occupies length consecutive
+ * slots starting at a rotating base, so the node at position pos is slot (base + pos) % capacity:
+ * every slot is its own anchor and anchors never shift. Pushing onto a full list evicts the value
+ * at the opposite end and reuses its node in place. Every operation is O(1) and allocation-free,
+ * except clear(), which destroys the values in O(length).
+ *
+ * The slots are raw storage: a value is constructed when pushed into a vacant slot and destroyed
+ * when popped or cleared. T need not be default-constructible unless pop_head or pop_tail are
+ * used (they return T() on an empty list), and popped or cleared values release what they hold
+ * right away.
+ *
+ * Nodes and iterators are the ones of DoublyLinkedList<T, S>.
+ *
+ * Constructors:
+ *     - BoundedDoublyLinkedList(S capacity);
+ */
+template <typename T, typename S = unsigned>
+class BoundedDoublyLinkedList {
+  public:
+    using Node = typename DoublyLinkedList<T, S>::Node;
+    using Iterator = typename DoublyLinkedList<T, S>::Iterator;
+    using ConstIterator = typename DoublyLinkedList<T, S>::ConstIterator;
+    using ReverseIterator = typename DoublyLinkedList<T, S>::ReverseIterator;
+    using ConstReverseIterator = typename DoublyLinkedList<T, S>::ConstReverseIterator;
+
+    BoundedDoublyLinkedList(S capacity) : _capacity(capacity), _nodes(std::allocator<Node>().allocate(capacity)) {
+        assert(capacity > 0);
+    }
+
+    BoundedDoublyLinkedList(const BoundedDoublyLinkedList&) = delete;
+    BoundedDoublyLinkedList& operator=(const BoundedDoublyLinkedList&) = delete;
+
+    BoundedDoublyLinkedList(BoundedDoublyLinkedList&& other) noexcept
+        : _capacity(other._capacity), _nodes(std::exchange(other._nodes, nullptr)), _base(other._base),
+          _len(std::exchange(other._len, 0)) {}
+
+    BoundedDoublyLinkedList&
+    operator=(BoundedDoublyLinkedList&& other) noexcept {
+        std::swap(_capacity, other._capacity);
+        std::swap(_nodes, other._nodes);
+        std::swap(_base, other._base);
+        std::swap(_len, other._len);
+        return *this;
+    }
+
+    ~BoundedDoublyLinkedList() {
+        clear();
+        if (_nodes != nullptr) {
+            std::allocator<Node>().deallocate(_nodes, _capacity);
+        }
+    }
+
+    void
+    clear(void) noexcept {
+        for (uint64_t pos = 0; pos < _len; ++pos) {
+            _slot(pos)->~Node();
+        }
+        _base = 0;
+        _len = 0;
+    }
+
+    // Evicts the head if the list is full
+    Node*
+    push_tail(const T& value) {
+        return _link_tail(_fill(_len == _capacity ? 0 : _len, value));
+    }
+
+    Node*
+    push_tail(T&& value) {
+        return _link_tail(_fill(_len == _capacity ? 0 : _len, std::move(value)));
+    }
+
+    // Evicts the tail if the list is full
+    Node*
+    push_head(const T& value) {
+        return _link_head(_fill(_capacity - 1, value));
+    }
+
+    Node*
+    push_head(T&& value) {
+        return _link_head(_fill(_capacity - 1, std::move(value)));
+    }
+
+    T
+    pop_head(void) noexcept {
+        if (_len == 0) {
+            return T();
+        }
+        T result = std::move(head()->value);
+        head()->~Node();
+        _base = _base + 1 == _capacity ? 0 : _base + 1;
+        if (--_len > 0) {
+            head()->prev = nullptr;
+        }
+        return result;
+    }
+
+    T
+    pop_tail(void) noexcept {
+        if (_len == 0) {
+            return T();
+        }
+        T result = std::move(tail()->value);
+        tail()->~Node();
+        if (--_len > 0) {
+            tail()->next = nullptr;
+        }
+        return result;
+    }
+
+    [[nodiscard]] Node*
+    at(uint64_t pos) const {
+        if (pos >= _len) {
+            throw std::out_of_range("pos >= length");
+        }
+        return _slot(pos);
+    }
+
+    friend std::ostream&
+    operator<<(std::ostream& os, const BoundedDoublyLinkedList<T, S>& list) noexcept {
+        os << "head -> ";
+        if (list.head() == nullptr) {
+            os << "nullptr";
+        } else {
+            os << list.head()->value;
+            for (auto it = ++list.cbegin(); it != list.cend(); ++it) {
+                os << " <-> " << *it;
+            }
+        }
+        os << " <- tail";
+        return os;
+    }
+
+    [[nodiscard]] constexpr bool
+    empty(void) const noexcept {
+        return _len == 0;
+    }
+
+    [[nodiscard]] constexpr bool
+    full(void) const noexcept {
+        return _len == _capacity;
+    }
+
+    [[nodiscard]] constexpr auto
+    length(void) const noexcept {
+        return _len;
+    }
+
+    [[nodiscard]] constexpr auto
+    capacity(void) const noexcept {
+        return _capacity;
+    }
+
+    [[nodiscard]] Node*
+    head(void) const noexcept {
+        return _len == 0 ? nullptr : _slot(0);
+    }
+
+    [[nodiscard]] Node*
+    tail(void) const noexcept {
+        return _len == 0 ? nullptr : _slot(_len - 1);
+    }
+
+    Iterator
+    begin() const {
+        return Iterator(head());
+    }
+
+    Iterator
+    end() const {
+        return Iterator(nullptr);
+    }
+
+    ConstIterator
+    cbegin() const {
+        return ConstIterator(head());
+    }
+
+    ConstIterator
+    cend() const {
+        return ConstIterator(nullptr);
+    }
+
+    ReverseIterator
+    rbegin() const {
+        return ReverseIterator(tail());
+    }
+
+    ReverseIterator
+    rend() const {
+        return ReverseIterator(nullptr);
+    }
+
+    ConstReverseIterator
+    crbegin() const {
+        return ConstReverseIterator(tail());
+    }
+
+    ConstReverseIterator
+    crend() const {
+        return ConstReverseIterator(nullptr);
+    }
+
+  private:
+    // Node at position pos counted from the base, pos < 2 * capacity
+    [[nodiscard]] Node*
+    _slot(uint64_t pos) const noexcept {
+        pos += _base;
+        return &_nodes[pos < _capacity ? pos : pos - _capacity];
+    }
+
+    // Slot pos counted from the base holding value: the evicted value is overwritten if the list is full,
+    // a vacant slot gets a node constructed in it
+    template <class U>
+    Node*
+    _fill(uint64_t pos, U&& value) {
+        Node* node = _slot(pos);
+        if (_len == _capacity) {
+            node->value = std::forward<U>(value);
+        } else {
+            new (node) Node{nullptr, std::forward<U>(value), nullptr};
+        }
+        return node;
+    }
+
+    // node holds the new value and is the slot after the tail (the head if the list is full)
+    Node*
+    _link_tail(Node* node) noexcept {
+        if (_len == _capacity) {
+            if (_capacity == 1) {
+                return node;
+            }
+            _base = _base + 1 == _capacity ? 0 : _base + 1;
+            head()->prev = nullptr;
+            --_len;
+        }
+        node->prev = tail();
+        node->next = nullptr;
+        if (node->prev != nullptr) {
+            node->prev->next = node;
+        }
+        ++_len;
+        return node;
+    }
+
+    // node holds the new value and is the slot before the head (the tail if the list is full)
+    Node*
+    _link_head(Node* node) noexcept {
+        if (_len == _capacity) {
+            if (_capacity == 1) {
+                return node;
+            }
+            --_len;
+            tail()->next = nullptr;
+        }
+        node->next = head();
+        node->prev = nullptr;
+        if (node->next != nullptr) {
+            node->next->prev = node;
+        }
+        _base = _base == 0 ? _capacity - 1 : _base - 1;
+        ++_len;
+        return node;
+    }
+
+    S _capacity;
+    // capacity slots, the length ones from the base on hold nodes
+    Node* _nodes;
+    // Slot of the head
+    S _base = 0;
+    uint64_t _len = 0;
+};
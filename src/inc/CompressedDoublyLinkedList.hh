@@ -0,0 +1,562 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Blocks are unpacked with AVX2 if the CPU has it; DOUBLY_LINKED_LIST_NO_AVX2 opts out, as for DoublyLinkedList
+#if (defined(__x86_64__) or defined(__i386__)) and defined(__GNUC__) and not defined(DOUBLY_LINKED_LIST_NO_AVX2)
+#define DOUBLY_LINKED_LIST_AVX2
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief append-mostly list of integers stored as delta encoded, bit packed segments
+ *
+ * @tparam T integral value type
+ * @tparam S size type = unsigned
+ *
+ * The list is cut into segments of size values, like the anchors of DoublyLinkedList. Every full
+ * segment is sealed into a block: its first value, the smallest delta between neighbours and, per
+ * neighbour, the delta minus that smallest delta packed into just as many bits as the largest of
+ * them needs. Increasing timestamps with a steady rate pack into a few bits per value instead of
+ * the 24 bytes of a node; a constant rate packs into none. The last, partial segment is kept raw.
+ *
+ * Reads decode one whole block into a cache and serve the rest of the segment from there, so
+ * iteration and at() on nearby positions decode every block once. set(), insert() and pop()
+ * re-encode only the block of their position: a block grown to 2 * size values is split in two,
+ * one popped empty is dropped, and the start positions of the blocks after it are shifted in
+ * O(length / size), like the anchors. pop_tail() unseals the last block when the raw segment runs
+ * empty.
+ *
+ * The cache makes const reads not thread-safe, unlike those of DoublyLinkedList.
+ *
+ * Constructors:
+ *     - CompressedDoublyLinkedList(S size);
+ *     - CompressedDoublyLinkedList(S size, std::initializer_list<T> init);
+ *     - template <class InputIt>
+ *       CompressedDoublyLinkedList(S size, const InputIt& begin, const InputIt& end);
+ */
+template <typename T, typename S = unsigned>
+class CompressedDoublyLinkedList {
+    static_assert(std::is_integral_v<T> and not std::is_same_v<T, bool>, "T must be an integer type");
+
+    using U = std::make_unsigned_t<T>;
+    using I = std::make_signed_t<T>;
+
+  public:
+    CompressedDoublyLinkedList(S size) : _size(size) {
+        assert(size > 0 and uint64_t(size) * 2 <= UINT32_MAX);
+        _tail.reserve(size);
+    }
+
+    CompressedDoublyLinkedList(S size, std::initializer_list<T> init)
+        : CompressedDoublyLinkedList(size, init.begin(), init.end()) {}
+
+    template <class InputIt>
+    CompressedDoublyLinkedList(S size, const InputIt& begin, const InputIt& end) : CompressedDoublyLinkedList(size) {
+        for (auto it = begin; it != end; ++it) {
+            push_tail(*it);
+        }
+    }
+
+    void
+    clear(void) noexcept {
+        _blocks.clear();
+        _starts.assign(1, 0);
+        _tail.clear();
+        _words = 0;
+        _cached = npos;
+    }
+
+    void
+    push_head(T value) {
+        insert(0, value);
+    }
+
+    void
+    push_tail(T value) {
+        _tail.push_back(value);
+        _seal();
+    }
+
+    // Re-encodes the block of pos, or two halves of it once it holds 2 * size values
+    void
+    insert(uint64_t pos, T value) {
+        if (pos > length()) {
+            throw std::out_of_range("pos > length");
+        }
+        if (pos >= _starts.back()) {
+            _tail.insert(_tail.begin() + (pos - _starts.back()), value);
+            _seal();
+            return;
+        }
+        uint64_t block = _block(pos);
+        _load(block);
+        _cache.insert(_cache.begin() + (pos - _starts[block]), value);
+        _words -= _blocks[block].count;
+        if (_cache.size() < uint64_t(_size) * 2) {
+            _blocks[block] = _encode(_cache.data(), _cache.size());
+        } else {
+            _blocks[block] = _encode(_cache.data(), _size);
+            _blocks.insert(_blocks.begin() + block + 1, _encode(_cache.data() + _size, _size));
+            _starts.insert(_starts.begin() + block + 1, _starts[block] + _size);
+            ++block;
+            _cached = npos;
+        }
+        for (uint64_t i = block + 1; i < _starts.size(); ++i) {
+            ++_starts[i];
+        }
+    }
+
+    T
+    pop_head(void) {
+        return empty() ? T() : pop(0);
+    }
+
+    T
+    pop_tail(void) {
+        if (empty()) {
+            return T();
+        }
+        if (_tail.empty()) {
+            _tail.resize(_blocks.back().length);
+            _decode(_blocks.back(), _tail.data());
+            _words -= _blocks.back().count;
+            _blocks.pop_back();
+            _starts.pop_back();
+            if (_cached == _blocks.size()) {
+                _cached = npos;
+            }
+        }
+        T result = _tail.back();
+        _tail.pop_back();
+        return result;
+    }
+
+    // Re-encodes the block of pos, or drops it once empty
+    T
+    pop(uint64_t pos) {
+        if (pos >= length()) {
+            throw std::out_of_range("pos >= length");
+        }
+        if (pos >= _starts.back()) {
+            T result = _tail[pos - _starts.back()];
+            _tail.erase(_tail.begin() + (pos - _starts.back()));
+            return result;
+        }
+        uint64_t block = _block(pos);
+        _load(block);
+        T result = _cache[pos - _starts[block]];
+        _cache.erase(_cache.begin() + (pos - _starts[block]));
+        _words -= _blocks[block].count;
+        uint64_t next = block + 1;
+        if (_cache.empty()) {
+            _blocks.erase(_blocks.begin() + block);
+            _starts.erase(_starts.begin() + block);
+            _cached = npos;
+            next = block;
+        } else {
+            _blocks[block] = _encode(_cache.data(), _cache.size());
+        }
+        for (uint64_t i = next; i < _starts.size(); ++i) {
+            --_starts[i];
+        }
+        return result;
+    }
+
+    [[nodiscard]] T
+    at(uint64_t pos) const {
+        if (pos >= length()) {
+            throw std::out_of_range("pos >= length");
+        }
+        return _value(pos);
+    }
+
+    // Re-encodes the block of pos, if any
+    void
+    set(uint64_t pos, T value) {
+        if (pos >= length()) {
+            throw std::out_of_range("pos >= length");
+        }
+        if (pos >= _starts.back()) {
+            _tail[pos - _starts.back()] = value;
+            return;
+        }
+        uint64_t block = _block(pos);
+        _load(block);
+        _cache[pos - _starts[block]] = value;
+        _words -= _blocks[block].count;
+        _blocks[block] = _encode(_cache.data(), _cache.size());
+    }
+
+    // Calls f(value) in order, decoding every block once
+    template <class F>
+    void
+    for_each(F f) const {
+        std::vector<T> values;
+        for (const Block& block : _blocks) {
+            values.resize(block.length);
+            _decode(block, values.data());
+            for (T value : values) {
+                f(value);
+            }
+        }
+        for (T value : _tail) {
+            f(value);
+        }
+    }
+
+    // Bytes held by the list, including blocks, the raw segment and the decode cache
+    [[nodiscard]] size_t
+    memory_usage(void) const noexcept {
+        return sizeof(*this) + _blocks.capacity() * sizeof(Block) + _starts.capacity() * sizeof(uint64_t)
+               + _words * sizeof(uint64_t)
+               + (_tail.capacity() + _cache.capacity()) * sizeof(T) + _deltas.capacity() * sizeof(U);
+    }
+
+    friend std::ostream&
+    operator<<(std::ostream& os, const CompressedDoublyLinkedList<T, S>& list) noexcept {
+        os << "head -> ";
+        if (list.empty()) {
+            os << "nullptr";
+        } else {
+            bool first = true;
+            list.for_each([&](T value) {
+                os << (first ? "" : " <-> ") << +value;
+                first = false;
+            });
+        }
+        os << " <- tail";
+        return os;
+    }
+
+    [[nodiscard]] bool
+    operator==(const CompressedDoublyLinkedList<T, S>& other) const {
+        if (length() != other.length()) {
+            return false;
+        }
+        return std::equal(cbegin(), cend(), other.cbegin());
+    }
+
+    [[nodiscard]] bool
+    operator!=(const CompressedDoublyLinkedList<T, S>& other) const {
+        return !(*this == other);
+    }
+
+    [[nodiscard]] bool
+    empty(void) const noexcept {
+        return length() == 0;
+    }
+
+    [[nodiscard]] uint64_t
+    length(void) const noexcept {
+        return _starts.back() + _tail.size();
+    }
+
+    [[nodiscard]] constexpr S
+    size(void) const noexcept {
+        return _size;
+    }
+
+    // Values are decoded on the fly, so dereferencing yields a copy
+    class ConstIterator {
+        const CompressedDoublyLinkedList* _list;
+        uint64_t _pos;
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = const T*;
+        using reference = T;
+
+        ConstIterator(const CompressedDoublyLinkedList* list, uint64_t pos) : _list{list}, _pos{pos} {}
+
+        [[nodiscard]] reference
+        operator*() const {
+            return _list->_value(_pos);
+        }
+
+        ConstIterator&
+        operator++() noexcept {
+            ++_pos;
+            return *this;
+        }
+
+        ConstIterator
+        operator++(int) noexcept {
+            ConstIterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        ConstIterator&
+        operator--() noexcept {
+            --_pos;
+            return *this;
+        }
+
+        ConstIterator
+        operator--(int) noexcept {
+            ConstIterator tmp = *this;
+            --(*this);
+            return tmp;
+        }
+
+        [[nodiscard]] bool
+        operator==(const ConstIterator& other) const noexcept {
+            return _pos == other._pos;
+        }
+
+        [[nodiscard]] bool
+        operator!=(const ConstIterator& other) const noexcept {
+            return !(*this == other);
+        }
+    };
+
+    ConstIterator
+    begin() const {
+        return cbegin();
+    }
+
+    ConstIterator
+    end() const {
+        return cend();
+    }
+
+    ConstIterator
+    cbegin() const {
+        return ConstIterator(this, 0);
+    }
+
+    ConstIterator
+    cend() const {
+        return ConstIterator(this, length());
+    }
+
+  private:
+    static constexpr uint64_t npos = ~uint64_t(0);
+
+    // A sealed segment of 1 to 2 * size - 1 values, size unless changed by insert or pop
+    struct Block {
+        T base = 0;
+        // Smallest delta, value i + 1 = value i + step + packed delta i (mod 2^bits of T)
+        U step = 0;
+        std::unique_ptr<uint64_t[]> words;
+        // Words allocated, one more than the packed deltas fill so decoding may always read two; none at width 0
+        uint32_t count = 0;
+        uint32_t length = 0;
+        uint8_t width = 0;
+
+        Block() = default;
+        Block(Block&&) noexcept = default;
+        Block& operator=(Block&&) noexcept = default;
+
+        Block(const Block& other)
+            : base(other.base), step(other.step), words(new uint64_t[other.count]), count(other.count),
+              length(other.length), width(other.width) {
+            std::copy(other.words.get(), other.words.get() + count, words.get());
+        }
+
+        Block&
+        operator=(const Block& other) {
+            return *this = Block(other);
+        }
+    };
+
+    // Packs the length values at values
+    Block
+    _encode(const T* values, uint64_t length) {
+        Block block;
+        block.base = values[0];
+        block.length = static_cast<uint32_t>(length);
+        std::vector<U>& deltas = _deltas;
+        deltas.resize(length - 1);
+        I step = 0;
+        for (uint64_t i = 0; i + 1 < length; ++i) {
+            deltas[i] = static_cast<U>(static_cast<U>(values[i + 1]) - static_cast<U>(values[i]));
+            step = i == 0 ? static_cast<I>(deltas[i]) : std::min(step, static_cast<I>(deltas[i]));
+        }
+        // Signed deltas minus their minimum never exceed the range of U
+        U bits = 0;
+        for (U& delta : deltas) {
+            delta = static_cast<U>(delta - static_cast<U>(step));
+            bits |= delta;
+        }
+        block.step = static_cast<U>(step);
+        block.width = bits == 0 ? 0 : 64 - __builtin_clzll(bits);
+        if (block.width == 0) {
+            return block;
+        }
+        block.count = static_cast<uint32_t>(((length - 1) * block.width + 63) / 64 + 1);
+        block.words.reset(new uint64_t[block.count]());
+        for (uint64_t i = 0; i + 1 < length; ++i) {
+            uint64_t bit = uint64_t(i) * block.width, delta = deltas[i];
+            // The second write is a no-op unless the delta straddles two words
+            block.words[bit / 64] |= delta << bit % 64;
+            block.words[bit / 64 + 1] |= delta >> 1 >> (63 - bit % 64);
+        }
+        _words += block.count;
+        return block;
+    }
+
+    // Unpacks block into the block.length values at values
+    void
+    _decode(const Block& block, T* values) const {
+        uint64_t length = block.length;
+        std::vector<U>& deltas = _deltas;
+        deltas.resize(length - 1);
+        if (block.width == 0) {
+            std::fill(deltas.begin(), deltas.end(), U(0));
+        } else {
+            _unpack(block, deltas.data());
+        }
+        U value = static_cast<U>(block.base);
+        values[0] = block.base;
+        for (uint64_t i = 0; i + 1 < length; ++i) {
+            value = static_cast<U>(value + block.step + deltas[i]);
+            values[i + 1] = static_cast<T>(value);
+        }
+    }
+
+    /**
+     * The packed deltas of block, width > 0, into deltas. Delta i is the width bits at bit
+     * i * width; the loop below reads the one or two words holding them, an indexed load per lane
+     * that the compiler does not vectorize, so _unpack_avx2 does most of the block when it can.
+     */
+    void
+    _unpack(const Block& block, U* deltas) const noexcept {
+        uint64_t length = block.length, i = 0;
+#ifdef DOUBLY_LINKED_LIST_AVX2
+        if (block.width <= 57 and _has_avx2()) {
+            i = _unpack_avx2(block, deltas);
+        }
+#endif
+        const uint64_t* words = block.words.get();
+        uint64_t width = block.width, mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+        for (; i + 1 < length; ++i) {
+            uint64_t bit = i * width;
+            uint64_t low = words[bit / 64] >> bit % 64, high = words[bit / 64 + 1] << 1 << (63 - bit % 64);
+            deltas[i] = static_cast<U>((low | high) & mask);
+        }
+    }
+
+#ifdef DOUBLY_LINKED_LIST_AVX2
+    [[nodiscard]] static bool
+    _has_avx2(void) noexcept {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+
+    /**
+     * _unpack four deltas at a time, returns how many it did. A delta of width <= 57 bits lies
+     * within the 8 bytes from byte bit / 8 on, which the words always hold in full: those are
+     * loaded per lane, shifted right by bit % 8 and masked. Four loads beat _mm256_i64gather_epi64,
+     * which microcode makes slow on recent Intel CPUs. The rest are left to _unpack.
+     */
+    __attribute__((target("avx2"))) static uint64_t
+    _unpack_avx2(const Block& block, U* deltas) noexcept {
+        uint64_t n = (block.length - 1) & ~uint64_t(3), width = block.width;
+        const char* bytes = reinterpret_cast<const char*>(block.words.get());
+        __m256i bits = _mm256_setr_epi64x(0, width, 2 * width, 3 * width);
+        __m256i stride = _mm256_set1_epi64x(4 * width), seven = _mm256_set1_epi64x(7);
+        __m256i mask = _mm256_set1_epi64x((int64_t(1) << width) - 1);
+        for (uint64_t i = 0, bit = 0; i < n; i += 4, bit += 4 * width) {
+            int64_t words[4];
+            for (uint64_t k = 0; k < 4; ++k) {
+                std::memcpy(&words[k], bytes + (bit + k * width) / 8, 8);
+            }
+            __m256i lanes = _mm256_setr_epi64x(words[0], words[1], words[2], words[3]);
+            lanes = _mm256_and_si256(_mm256_srlv_epi64(lanes, _mm256_and_si256(bits, seven)), mask);
+            _store(deltas + i, lanes);
+            bits = _mm256_add_epi64(bits, stride);
+        }
+        return n;
+    }
+
+    // Stores four lanes of 64 bits, each below 2^(8 * sizeof(U)), as four U
+    __attribute__((target("avx2"))) static void
+    _store(U* out, __m256i lanes) noexcept {
+        if constexpr (sizeof(U) == 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), lanes);
+        } else {
+            // The low halves of the lanes, then narrowed without saturating as they fit
+            __m128i low = _mm256_castsi256_si128(
+                _mm256_permutevar8x32_epi32(lanes, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+            if constexpr (sizeof(U) == 4) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), low);
+            } else if constexpr (sizeof(U) == 2) {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi32(low, low));
+            } else {
+                __m128i words = _mm_packus_epi32(low, low);
+                int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+                std::memcpy(out, &packed, 4);
+            }
+        }
+    }
+#endif
+
+    // Decodes block into the cache unless it is there already
+    void
+    _load(uint64_t block) const {
+        if (_cached != block) {
+            _cache.resize(_blocks[block].length);
+            _decode(_blocks[block], _cache.data());
+            _cached = block;
+        }
+    }
+
+    // Block holding pos < _starts.back(), the cached one first since reads tend to stay close
+    [[nodiscard]] uint64_t
+    _block(uint64_t pos) const {
+        if (_cached != npos and _starts[_cached] <= pos and pos < _starts[_cached + 1]) {
+            return _cached;
+        }
+        return std::upper_bound(_starts.begin(), _starts.end(), pos) - _starts.begin() - 1;
+    }
+
+    [[nodiscard]] T
+    _value(uint64_t pos) const {
+        if (pos >= _starts.back()) {
+            return _tail[pos - _starts.back()];
+        }
+        uint64_t block = _block(pos);
+        _load(block);
+        return _cache[pos - _starts[block]];
+    }
+
+    // Seals the raw segment once full, or longer after pop_tail unsealed a grown block
+    void
+    _seal(void) {
+        if (_tail.size() >= _size) {
+            _blocks.push_back(_encode(_tail.data(), _tail.size()));
+            _starts.push_back(_starts.back() + _tail.size());
+            _tail.clear();
+        }
+    }
+
+    S _size;
+    std::vector<Block> _blocks;
+    // Position of the first value of every block, then of the raw segment
+    std::vector<uint64_t> _starts = {0};
+    // The partial segment after the last block, raw
+    std::vector<T> _tail;
+    // Total words of all blocks
+    uint64_t _words = 0;
+    // Decoded values of block _cached
+    mutable std::vector<T> _cache;
+    mutable uint64_t _cached = npos;
+    // Scratch of _encode and _decode
+    mutable std::vector<U> _deltas;
+};
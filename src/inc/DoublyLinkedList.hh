@@ -1,16 +1,227 @@
 #pragma once
 
+#include <unistd.h>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <exception>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <initializer_list>
 #include <iostream>
 #include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
 #include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
+#if __has_include(<version>)
+#include <version>
+#endif
+#ifdef __cpp_lib_ranges
+#include <ranges>
+#endif
+#ifdef __cpp_lib_span
+#include <span>
+#endif
+
+// Define DOUBLY_LINKED_LIST_PREFETCH to issue software prefetches while traversing
+#ifndef DOUBLY_LINKED_LIST_PREFETCH_DISTANCE
+// Nodes ahead of the current one that are prefetched when the layout is contiguous (see compact)
+#define DOUBLY_LINKED_LIST_PREFETCH_DISTANCE 8
+#endif
+
+/*
+ * Kernels over contiguous nodes (find, count, min, max, sum, operator==) get an AVX2 build chosen
+ * at run time, find and count written with intrinsics. Define DOUBLY_LINKED_LIST_NO_AVX2 to keep
+ * only the portable ones.
+ */
+#if (defined(__x86_64__) or defined(__i386__)) and defined(__GNUC__) and not defined(DOUBLY_LINKED_LIST_NO_AVX2)
+#define DOUBLY_LINKED_LIST_AVX2
+#include <immintrin.h>
+#endif
+
+/*
+ * Define DOUBLY_LINKED_LIST_STATS (identically in every translation unit) to collect operation
+ * counters and latency histograms, see DoublyLinkedList::stats(). Without it nothing is recorded.
+ * Const calls count too and may run concurrently, so every update is a relaxed atomic add.
+ */
+#ifdef DOUBLY_LINKED_LIST_STATS
+#define DOUBLY_LINKED_LIST_COUNT(counter, n) __atomic_fetch_add(&_stats.counter, (n), __ATOMIC_RELAXED)
+#else
+#define DOUBLY_LINKED_LIST_COUNT(counter, n) static_cast<void>(0)
+#endif
+
+// Base of the views handed out by DoublyLinkedList, which makes them std::ranges views in C++20
+#ifdef __cpp_lib_ranges
+template <class D>
+using DoublyLinkedListView = std::ranges::view_interface<D>;
+#else
+template <class D>
+struct DoublyLinkedListView {};
+#endif
+
+/**
+ * Consecutive values of a DoublyLinkedList between two of its iterators. It refers to the nodes
+ * of the list, so it is a borrowed range: iterators into it outlive the slice itself.
+ */
+template <class It>
+class DoublyLinkedListSlice : public DoublyLinkedListView<DoublyLinkedListSlice<It>> {
+    It _begin;
+    It _end;
+    uint64_t _len = 0;
+
+  public:
+    DoublyLinkedListSlice() = default;
+
+    DoublyLinkedListSlice(It begin, It end, uint64_t len) : _begin{begin}, _end{end}, _len{len} {}
+
+    [[nodiscard]] It
+    begin() const noexcept {
+        return _begin;
+    }
+
+    [[nodiscard]] It
+    end() const noexcept {
+        return _end;
+    }
+
+    [[nodiscard]] uint64_t
+    size() const noexcept {
+        return _len;
+    }
+
+    [[nodiscard]] bool
+    empty() const noexcept {
+        return _len == 0;
+    }
+};
+
+#ifdef __cpp_lib_ranges
+template <class It>
+inline constexpr bool std::ranges::enable_borrowed_range<DoublyLinkedListSlice<It>> = true;
+#endif
+
+/**
+ * Worker threads shared by the parallel algorithms of every DoublyLinkedList. They are started on
+ * first use and added whenever a call asks for more helpers than there are, then stay for the
+ * rest of the process. A caller waiting for its tasks runs queued tasks itself, so a parallel
+ * call nested in another one cannot starve on busy workers.
+ */
+class DoublyLinkedListPool {
+  public:
+    [[nodiscard]] static DoublyLinkedListPool&
+    instance(void) {
+        static DoublyLinkedListPool pool;
+        return pool;
+    }
+
+    DoublyLinkedListPool(const DoublyLinkedListPool&) = delete;
+    DoublyLinkedListPool& operator=(const DoublyLinkedListPool&) = delete;
+
+    ~DoublyLinkedListPool() {
+        {
+            std::lock_guard lock(_mutex);
+            _stop = true;
+        }
+        _changed.notify_all();
+        for (std::thread& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    // Calls f(i) for every i in [1, n) on the workers and f(0) on the calling thread, then rethrows the first exception
+    template <class F>
+    void
+    run(unsigned n, F& f) {
+        std::vector<std::exception_ptr> errors(n);
+        unsigned pending = n - 1;
+        auto task = [this, &f, &errors, &pending](unsigned i) -> void {
+            try {
+                f(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            std::lock_guard lock(_mutex);
+            --pending;
+            _changed.notify_all();
+        };
+        {
+            std::lock_guard lock(_mutex);
+            while (_workers.size() < n - 1) {
+                _workers.emplace_back([this]() -> void { _work(); });
+            }
+            for (unsigned i = 1; i < n; ++i) {
+                _tasks.emplace_back([&task, i]() -> void { task(i); });
+            }
+        }
+        _changed.notify_all();
+        try {
+            f(0);
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+
+        std::unique_lock lock(_mutex);
+        while (pending > 0) {
+            if (_tasks.empty()) {
+                _changed.wait(lock);
+                continue;
+            }
+            std::function<void()> queued = std::move(_tasks.front());
+            _tasks.pop_front();
+            lock.unlock();
+            queued();
+            lock.lock();
+        }
+        lock.unlock();
+        for (const std::exception_ptr& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+  private:
+    DoublyLinkedListPool() = default;
+
+    void
+    _work(void) {
+        std::unique_lock lock(_mutex);
+        while (true) {
+            _changed.wait(lock, [this]() -> bool { return _stop or not _tasks.empty(); });
+            if (_tasks.empty()) {
+                return;
+            }
+            std::function<void()> queued = std::move(_tasks.front());
+            _tasks.pop_front();
+            lock.unlock();
+            queued();
+            lock.lock();
+        }
+    }
+
+    std::mutex _mutex;
+    // Signals new tasks, finished tasks and the stop
+    std::condition_variable _changed;
+    std::deque<std::function<void()>> _tasks;
+    std::vector<std::thread> _workers;
+    bool _stop = false;
+};
 
 /**
  * @brief doubly linked list implementation with vector of references to every size-th element
@@ -28,120 +239,162 @@
 template <typename T, typename S = unsigned>
 class DoublyLinkedList {
   public:
+    // prev and next are the links in storage order, which is the reverse of the list after reverse()
     struct Node {
         Node* prev;
         T value;
         Node* next;
     };
 
+    // Execution policies for bulk algorithms (for_each, reduce, transform_inplace, count_if)
+    struct Sequenced {};
+
+    struct Parallel {
+        // 0 = std::thread::hardware_concurrency()
+        unsigned threads = 0;
+    };
+
+    static constexpr Sequenced seq{};
+    static constexpr Parallel par{};
+
+    // Snapshot returned by stats(), all zeros unless DOUBLY_LINKED_LIST_STATS is defined
+    struct Stats {
+        enum Operation {
+            push_head,
+            push_tail,
+            insert,
+            pop_head,
+            pop_tail,
+            pop,
+            erase,
+            move,
+            rotate,
+            batch,
+            at,
+            sort,
+            resize,
+            operations
+        };
+
+        // Nodes walked by at() from its anchor
+        uint64_t hops = 0;
+        // _refs entries moved to a neighbouring node by push_head, insert, pop_head and pop
+        uint64_t shifted = 0;
+        // Nodes handed out / taken back by the node pool, blocks allocated by it
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t blocks = 0;
+        // Times _refs had to grow its storage
+        uint64_t reallocations = 0;
+        // Value comparisons made by sort()
+        uint64_t comparisons = 0;
+        // Rebuilds of _refs left stale by node handle operations (erase, move_to_head)
+        uint64_t repairs = 0;
+        // Segments copied out to snapshots before being changed
+        uint64_t detached = 0;
+        // latency[operation][i] = calls that took [2^i, 2^(i + 1)) ns, nested calls are counted as well
+        static constexpr size_t buckets = 40;
+        std::array<std::array<uint64_t, buckets>, operations> latency{};
+    };
+
     DoublyLinkedList(S size) noexcept : _size(size) { assert(size > 0); }
 
     DoublyLinkedList(S size, std::initializer_list<T> init) : _size(size) {
         assert(size > 0);
-        for (const T& value : init) {
-            push_tail(value);
-        }
+        _assign(init.begin(), init.size());
     }
 
     DoublyLinkedList(S size, T* start, T* stop) : _size(size) {
         assert(size > 0);
-        for (; start != stop; ++start) {
-            push_tail(*start);
-        }
+        _assign(start, stop - start);
     }
 
+    // Random access ranges are built in one block of nodes, see _assign
     template <class InputIt>
     DoublyLinkedList(S size, const InputIt& begin, const InputIt& end) : _size(size) {
         assert(size > 0);
-        for (auto it = begin; it != end; ++it) {
-            push_tail(*it);
+        if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                                        typename std::iterator_traits<InputIt>::iterator_category>) {
+            _assign(begin, end - begin);
+        } else {
+            for (auto it = begin; it != end; ++it) {
+                push_tail(*it);
+            }
+        }
+    }
+
+    DoublyLinkedList(const DoublyLinkedList& other)
+        : from_string(other.from_string), _size(other._size), _fingerprinted(other._fingerprinted) {
+        for (const T& value : other) {
+            push_tail(value);
         }
     }
 
+    DoublyLinkedList(DoublyLinkedList&& other) noexcept
+        : from_string(std::move(other.from_string)), _len(std::exchange(other._len, 0)),
+          _refs(std::exchange(other._refs, {nullptr, nullptr})), _dirty(std::exchange(other._dirty, false)),
+          _reversed(std::exchange(other._reversed, false)), _contiguous(std::exchange(other._contiguous, false)),
+          _size(other._size),
+          _blocks(std::exchange(other._blocks, {})), _used(std::exchange(other._used, 0)),
+          _peak(std::exchange(other._peak, 0)), _free(std::exchange(other._free, nullptr)),
+          _snapshots(std::exchange(other._snapshots, {})),
+          _fingerprinted(std::exchange(other._fingerprinted, false)), _hashes(std::exchange(other._hashes, {})),
+          _powers(std::exchange(other._powers, {})) {}
+
     ~DoublyLinkedList() { this->clear(); }
 
     void
     clear(void) noexcept {
-        std::function<void(Node*)> _delete;
-        _delete = [&_delete](Node* head) -> void {
-            if (head == nullptr) {
-                return;
-            }
-            _delete(head->next);
-            delete head;
-        };
-        _delete(_refs[0]);
+        // Terminates if copying values out to snapshots throws
+        _detach_all();
+        for (Node* node = _refs.front(); node != nullptr;) {
+            DOUBLY_LINKED_LIST_COUNT(frees, 1);
+            Node* next = node->next;
+            node->~Node();
+            node = next;
+        }
+        for (const Block& block : _blocks) {
+            std::allocator<Node>().deallocate(block.nodes, block.capacity);
+        }
+        _blocks.clear();
+        _used = 0;
+        _peak = 0;
+        _free = nullptr;
 
         _len = 0;
         _refs = {nullptr, nullptr};
+        _dirty = false;
+        _reversed = false;
+        _contiguous = false;
     }
 
     Node*
     push_tail(const T& value) {
-        ++_len;
-        if (_refs.front() == nullptr) {
-            return _refs.front() = _refs.back() = new Node{nullptr, value, nullptr};
-        }
-        if (_len > 2 and (_len - 2) % _size == 0) {
-            Node* new_node = new Node{_refs.back(), value, nullptr};
-            _refs.back()->next = new_node;
-            _refs.push_back(new_node);
-            return new_node;
-        }
-        return _refs.back() = _refs.back()->next = new Node{_refs.back(), value, nullptr};
+        [[maybe_unused]] Timer timer = _time(Stats::push_tail);
+        return _reversed ? _push_front(value) : _push_back(value);
     }
 
     Node*
     push_tail(T&& value) {
-        ++_len;
-        if (_refs.front() == nullptr) {
-            return _refs.front() = _refs.back() = new Node{nullptr, std::move(value), nullptr};
-        }
-        if (_len > 2 and (_len - 2) % _size == 0) {
-            Node* new_node = new Node{_refs.back(), std::move(value), nullptr};
-            _refs.back()->next = new_node;
-            _refs.push_back(new_node);
-            return new_node;
-        }
-        return _refs.back() = _refs.back()->next = new Node{_refs.back(), std::move(value), nullptr};
+        [[maybe_unused]] Timer timer = _time(Stats::push_tail);
+        return _reversed ? _push_front(std::move(value)) : _push_back(std::move(value));
     }
 
     Node*
     push_head(const T& value) {
-        ++_len;
-        if (_refs.front() == nullptr) {
-            return _refs.front() = _refs.back() = new Node{nullptr, value, nullptr};
-        }
-        _refs.front()->prev = new Node{nullptr, value, _refs.front()};
-        for (size_t i = 0; i < _refs.size() - 1; ++i) {
-            _refs[i] = _refs[i]->prev;
-        }
-        if (_len > 2 and (_len - 2) % _size == 0) {
-            _refs.back() = _refs.back()->prev;
-            _refs.push_back(_refs.back()->next);
-        }
-        return _refs.front();
+        [[maybe_unused]] Timer timer = _time(Stats::push_head);
+        return _reversed ? _push_back(value) : _push_front(value);
     }
 
     Node*
     push_head(T&& value) {
-        ++_len;
-        if (_refs.front() == nullptr) {
-            return _refs.front() = _refs.back() = new Node{nullptr, std::move(value), nullptr};
-        }
-        _refs.front()->prev = new Node{nullptr, std::move(value), _refs.front()};
-        for (size_t i = 0; i < _refs.size() - 1; ++i) {
-            _refs[i] = _refs[i]->prev;
-        }
-        if (_len > 2 and (_len - 2) % _size == 0) {
-            _refs.back() = _refs.back()->prev;
-            _refs.push_back(_refs.back()->next);
-        }
-        return _refs.front();
+        [[maybe_unused]] Timer timer = _time(Stats::push_head);
+        return _reversed ? _push_back(std::move(value)) : _push_front(std::move(value));
     }
 
     Node*
     insert(uint64_t pos, const T& value) {
+        [[maybe_unused]] Timer timer = _time(Stats::insert);
         if (pos == 0) {
             return push_head(value);
         }
@@ -151,22 +404,12 @@ class DoublyLinkedList {
         if (pos > _len) {
             throw std::out_of_range("pos > length");
         }
-
-        Node* node = at(pos);
-        node->prev = node->prev->next = new Node{node->prev, value, node};
-        for (size_t i = (pos % _size ? 1 : 0) + pos / _size; i < _refs.size() - 1; ++i) {
-            _refs[i] = _refs[i]->prev;
-        }
-        ++_len;
-        if (_len > 2 and (_len - 2) % _size == 0) {
-            _refs.back() = _refs.back()->prev;
-            _refs.push_back(_refs.back()->next);
-        }
-        return node->prev;
+        return _insert(_reversed ? _len - pos : pos, value);
     }
 
     Node*
     insert(uint64_t pos, T&& value) {
+        [[maybe_unused]] Timer timer = _time(Stats::insert);
         if (pos == 0) {
             return push_head(std::move(value));
         }
@@ -176,18 +419,7 @@ class DoublyLinkedList {
         if (pos > _len) {
             throw std::out_of_range("pos > length");
         }
-
-        Node* node = at(pos);
-        node->prev = node->prev->next = new Node{node->prev, std::move(value), node};
-        for (size_t i = (pos % _size ? 1 : 0) + pos / _size; i < _refs.size() - 1; ++i) {
-            _refs[i] = _refs[i]->prev;
-        }
-        ++_len;
-        if (_len > 2 and (_len - 2) % _size == 0) {
-            _refs.back() = _refs.back()->prev;
-            _refs.push_back(_refs.back()->next);
-        }
-        return node->prev;
+        return _insert(_reversed ? _len - pos : pos, std::move(value));
     }
 
     Node*
@@ -211,51 +443,19 @@ class DoublyLinkedList {
 
     T
     pop_tail(void) noexcept {
-        if (_refs.front() == nullptr) {
-            return T();
-        }
-        --_len;
-        T result = _refs.back()->value;
-
-        if (_len == 0) {
-            _refs = {nullptr, nullptr};
-        } else {
-            _refs.back() = _refs.back()->prev;
-            delete _refs.back()->next;
-            _refs.back()->next = nullptr;
-            if ((_len - 1) % _size == 0) {
-                _refs.pop_back();
-            }
-        }
-        return result;
+        [[maybe_unused]] Timer timer = _time(Stats::pop_tail);
+        return _reversed ? _pop_front() : _pop_back();
     }
 
     T
     pop_head(void) noexcept {
-        if (_refs.front() == nullptr) {
-            return T();
-        }
-        --_len;
-        T result = _refs.front()->value;
-
-        if (_len == 0) {
-            _refs = {nullptr, nullptr};
-        } else {
-            _refs.front() = _refs.front()->next;
-            delete _refs.front()->prev;
-            _refs.front()->prev = nullptr;
-            for (uint64_t i = 1; i < _refs.size() - 1; ++i) {
-                _refs[i] = _refs[i]->next;
-            }
-            if ((_len - 1) % _size == 0) {
-                _refs.pop_back();
-            }
-        }
-        return result;
+        [[maybe_unused]] Timer timer = _time(Stats::pop_head);
+        return _reversed ? _pop_back() : _pop_front();
     }
 
     T
     pop(uint64_t pos) {
+        [[maybe_unused]] Timer timer = _time(Stats::pop);
         if (pos == 0) {
             return pop_head();
         }
@@ -264,67 +464,317 @@ class DoublyLinkedList {
         }
         Node* node = at(pos);
         T result = node->value;
+        if (_reversed) {
+            pos = _len - 1 - pos;
+        }
+        _snapshot_erase(pos);
 
         --_len;
         node->prev->next = node->next;
         node->next->prev = node->prev;
-        delete node;
+        _contiguous = false;
         for (uint64_t i = (pos % _size ? 1 : 0) + pos / _size; i < _refs.size() - 1; ++i) {
             _refs[i] = _refs[i]->next;
+            DOUBLY_LINKED_LIST_COUNT(shifted, 1);
         }
         if ((_len - 1) % _size == 0) {
-            _refs.pop_back();
+            _pop_ref();
+        }
+        _hash_erase(pos);
+        // Last, node may be an anchor shifted above and _delete_node may give its block back
+        _delete_node(node);
+
+        return result;
+    }
+
+    // Edit of apply_batch: insert value at pos, or pop the value at pos
+    struct Op {
+        enum Kind { insert, pop } kind;
+        uint64_t pos;
+        T value{};
+    };
+
+    /**
+     * Applies ops in order, each pos referring to the list as the ops before it left it, and
+     * returns the popped values in order. The ops are first replayed on an implicit treap of
+     * pieces (runs of the original positions and inserted values), which tells where every value
+     * ends up in O(k log k) for k ops; then one sweep relinks the runs that stay and the new
+     * nodes, and _refs is rebuilt once: O(length + k log k) in total. If any pos is out of range,
+     * std::out_of_range is thrown and the list is left unchanged.
+     */
+    template <class ForwardIt>
+    std::vector<T>
+    apply_batch(const ForwardIt& begin, const ForwardIt& end) {
+        static_assert(std::is_base_of_v<std::forward_iterator_tag,
+                                        typename std::iterator_traits<ForwardIt>::iterator_category>,
+                      "apply_batch counts the ops before replaying them, so it needs forward iterators");
+        [[maybe_unused]] Timer timer = _time(Stats::batch);
+        Pieces pieces(_len, static_cast<uint64_t>(std::distance(begin, end)));
+        std::vector<T> inserted;
+        // (original position, index into the result) of every popped original value
+        std::vector<std::pair<uint64_t, uint64_t>> originals;
+        std::vector<T> popped;
+        for (auto it = begin; it != end; ++it) {
+            const Op& op = *it;
+            if (op.kind == Op::insert) {
+                if (op.pos > pieces.length()) {
+                    throw std::out_of_range("pos > length");
+                }
+                pieces.insert(op.pos, inserted.size());
+                inserted.push_back(op.value);
+            } else {
+                if (op.pos >= pieces.length()) {
+                    throw std::out_of_range("pos >= length");
+                }
+                const typename Pieces::Piece& piece = pieces.pop(op.pos);
+                if (piece.end == Pieces::nil) {
+                    popped.push_back(std::move(inserted[piece.begin]));
+                } else {
+                    originals.emplace_back(piece.begin, popped.size());
+                    popped.emplace_back();
+                }
+            }
+        }
+        if (popped.empty() and inserted.empty()) {
+            return popped;
+        }
+        std::vector<uint64_t> order = pieces.order();
+
+        // The new nodes are made up front, so that the sweep cannot fail halfway
+        std::vector<Node*> nodes(inserted.size(), nullptr);
+        try {
+            for (uint64_t piece : order) {
+                if (pieces[piece].end == Pieces::nil) {
+                    uint64_t i = pieces[piece].begin;
+                    nodes[i] = _new_node(nullptr, std::move(inserted[i]), nullptr);
+                }
+            }
+        } catch (...) {
+            for (Node* node : nodes) {
+                if (node != nullptr) {
+                    _delete_node(node);
+                }
+            }
+            throw;
+        }
+        _detach_all();
+        if (_reversed) {
+            _normalize();
+        }
+        std::sort(originals.begin(), originals.end());
+        _repair();
+
+        // Nodes of the original positions the sweep visits, in ascending order: walks to a close one,
+        // jumps by the anchors to the others, so that a few ops do not walk the whole list
+        Node* node = _refs.front();
+        uint64_t pos = 0;
+        auto seek = [this, &node, &pos](uint64_t target) -> Node* {
+            if (target - pos >= _size) {
+                node = _refs[target / _size];
+                pos = target - target % _size;
+            }
+            for (; pos < target; ++pos) {
+                node = node->next;
+            }
+            return node;
+        };
+        // First and last node of every run that stays
+        std::vector<std::pair<Node*, Node*>> runs;
+        for (uint64_t piece : order) {
+            if (pieces[piece].end != Pieces::nil) {
+                Node* first = seek(pieces[piece].begin);
+                runs.emplace_back(first, seek(pieces[piece].end - 1));
+            }
+        }
+        std::vector<Node*> dropped;
+        dropped.reserve(originals.size());
+        node = _refs.front();
+        pos = 0;
+        for (const auto& [original, _] : originals) {
+            dropped.push_back(seek(original));
+        }
+
+        Node *head = nullptr, *tail = nullptr;
+        auto link = [&head, &tail](Node* first, Node* last) -> void {
+            first->prev = tail;
+            (tail != nullptr ? tail->next : head) = first;
+            tail = last;
+        };
+        auto run = runs.begin();
+        for (uint64_t piece : order) {
+            if (pieces[piece].end == Pieces::nil) {
+                Node* inserted = nodes[pieces[piece].begin];
+                link(inserted, inserted);
+            } else {
+                link(run->first, run->second);
+                ++run;
+            }
+        }
+        if (tail != nullptr) {
+            tail->next = nullptr;
         }
+        for (uint64_t i = 0; i < dropped.size(); ++i) {
+            popped[originals[i].second] = std::move(dropped[i]->value);
+            _delete_node(dropped[i]);
+        }
+
+        _len = pieces.length();
+        _refs.front() = head;
+        _refs.back() = tail;
+        _contiguous = false;
+        _rebuild_refs();
+        return popped;
+    }
+
+    std::vector<T>
+    apply_batch(std::initializer_list<Op> ops) {
+        return apply_batch(ops.begin(), ops.end());
+    }
 
+#ifdef __cpp_lib_span
+    std::vector<T>
+    apply_batch(std::span<const Op> ops) {
+        return apply_batch(ops.begin(), ops.end());
+    }
+#endif
+
+    /**
+     * Node handle operations, O(1) for any node of this list. They relink nodes in place and
+     * keep only head and tail exact: the anchors in between are left stale and _refs is rebuilt
+     * in O(length) by the next call that needs positions (at, insert, pop, compact, bulk
+     * algorithms). That call may be const, so it must not race with other calls then.
+     */
+    T
+    erase(Node* node) {
+        [[maybe_unused]] Timer timer = _time(Stats::erase);
+        if (node == _refs.back()) {
+            return _pop_back();
+        }
+        _detach_all();
+        T result = std::move(node->value);
+        _unlink(node);
+        _delete_node(node);
+        --_len;
+        _stale();
         return result;
     }
 
+    Node*
+    insert_before(Node* node, const T& value) {
+        [[maybe_unused]] Timer timer = _time(Stats::insert);
+        return _reversed ? _insert_after(node, value) : _insert_before(node, value);
+    }
+
+    Node*
+    insert_before(Node* node, T&& value) {
+        [[maybe_unused]] Timer timer = _time(Stats::insert);
+        return _reversed ? _insert_after(node, std::move(value)) : _insert_before(node, std::move(value));
+    }
+
+    Node*
+    insert_after(Node* node, const T& value) {
+        [[maybe_unused]] Timer timer = _time(Stats::insert);
+        return _reversed ? _insert_before(node, value) : _insert_after(node, value);
+    }
+
+    Node*
+    insert_after(Node* node, T&& value) {
+        [[maybe_unused]] Timer timer = _time(Stats::insert);
+        return _reversed ? _insert_before(node, std::move(value)) : _insert_after(node, std::move(value));
+    }
+
+    // Moves node in front of next, or behind the tail if next is nullptr
+    Node*
+    move_before(Node* node, Node* next) noexcept {
+        [[maybe_unused]] Timer timer = _time(Stats::move);
+        if (_reversed) {
+            // In front of next is behind it in storage order
+            return _move_before(node, next == nullptr ? _refs.front() : next->next);
+        }
+        return _move_before(node, next);
+    }
+
+    Node*
+    move_to_head(Node* node) noexcept {
+        [[maybe_unused]] Timer timer = _time(Stats::move);
+        return _move_before(node, _reversed ? nullptr : _refs.front());
+    }
+
+    // O(1): flips which end is the head; nodes keep their links, see Node
+    void
+    reverse(void) noexcept {
+        _reversed = not _reversed;
+    }
+
+    [[nodiscard]] constexpr bool
+    reversed(void) const noexcept {
+        return _reversed;
+    }
+
+    /**
+     * Makes the value at position k % length the head: the list is closed into a ring and cut
+     * again in front of it. Finding it takes at most size / 2 hops from an anchor, or
+     * min(k, length - k) from the ends if the anchors are stale. Like the node handle
+     * operations, this keeps only head and tail exact, so rotating repeatedly costs no anchor
+     * upkeep and the next positional access rebuilds _refs once.
+     */
+    void
+    rotate(uint64_t k) {
+        [[maybe_unused]] Timer timer = _time(Stats::rotate);
+        if (_len < 2 or k % _len == 0) {
+            return;
+        }
+        // New head in storage order
+        uint64_t pos = _reversed ? _len - k % _len : k % _len;
+        _detach_all();
+        Node* pivot = _dirty ? _walk_to(pos) : _locate(pos);
+
+        _refs.back()->next = _refs.front();
+        _refs.front()->prev = _refs.back();
+        _refs.front() = pivot;
+        _refs.back() = pivot->prev;
+        pivot->prev->next = nullptr;
+        pivot->prev = nullptr;
+        _stale();
+    }
+
     [[nodiscard]] Node*
     at(uint64_t pos) const {
+        [[maybe_unused]] Timer timer = _time(Stats::at);
         if (pos >= _len) {
             throw std::out_of_range("pos >= length");
         }
-
-        Node* node = _refs[pos / _size];
-        for (S i = 0; i < pos % _size; ++i) {
-            node = node->next;
-        }
-        return node;
+        return _at(_reversed ? _len - 1 - pos : pos);
     }
 
     void
     resize(S size) noexcept {
+        [[maybe_unused]] Timer timer = _time(Stats::resize);
         _size = size;
-        Node* curr = _refs.front();
-        _refs.clear();
-        for (S i = 0; curr->next != nullptr; ++i, curr = curr->next) {
-            if (i % size == 0) {
-                _refs.push_back(curr);
-            }
-        }
-        _refs.push_back(curr);
+        _hashes.clear();
+        _rebuild_refs();
     }
 
     void
     sort(bool descending = false) noexcept {
-        std::function<Node*(Node*, Node*)> _merge;
-        _merge = [&_merge, descending](Node* left, Node* right) -> Node* {
-            if (left == nullptr) {
-                return right;
+        [[maybe_unused]] Timer timer = _time(Stats::sort);
+        auto _merge = [this, descending](Node* left, Node* right) -> Node* {
+            Node *result = nullptr, *prev = nullptr;
+            Node** link = &result;
+            while (left != nullptr and right != nullptr) {
+                DOUBLY_LINKED_LIST_COUNT(comparisons, 1);
+                Node*& taken = (descending ? left->value >= right->value : left->value <= right->value) ? left : right;
+                Node* node = taken;
+                taken = node->next;
+                _prefetch(taken);
+
+                node->prev = prev;
+                *link = prev = node;
+                link = &node->next;
             }
-            if (right == nullptr) {
-                return left;
-            }
-            Node* result = nullptr;
-
-            if (descending ? left->value >= right->value : left->value <= right->value) {
-                result = left;
-                result->next = _merge(left->next, right);
-                result->next->prev = result;
-            } else {
-                result = right;
-                result->next = _merge(left, right->next);
-                result->next->prev = result;
+            *link = left != nullptr ? left : right;
+            if (*link != nullptr) {
+                (*link)->prev = prev;
             }
             return result;
         };
@@ -333,6 +783,7 @@ class DoublyLinkedList {
             Node *slow = head, *fast = head->next;
             while (fast != nullptr) {
                 fast = fast->next;
+                _prefetch_hop(fast);
                 if (fast != nullptr) {
                     slow = slow->next;
                     fast = fast->next;
@@ -357,34 +808,247 @@ class DoublyLinkedList {
             *head = _merge(left, right);
         };
 
+        // Sorting relinks every node, so the result is simply laid out in storage order
+        _detach_all();
+        _reversed = false;
+        _contiguous = false;
         _merge_sort(&_refs.front());
         resize(_size);
     }
 
-    DoublyLinkedList<T>&
-    operator=(const DoublyLinkedList<T>& other) {
-        clear();
-        for (const T& value : other) {
-            push_tail(value);
+    /**
+     * Moves every value into one freshly allocated block in list order, rewrites prev/next and
+     * _refs and releases all previously allocated blocks. Afterwards node i lives at head() + i,
+     * so a scan touches memory sequentially. Invalidates every Node* handed out before. The block
+     * gets room for spare more nodes, which the next push_tail calls take, so the layout stays
+     * contiguous for find() and the other kernels while the list grows by up to spare values.
+     */
+    void
+    compact(uint64_t spare = 0) {
+        if (_len == 0) {
+            return;
+        }
+        _detach_all();
+        _normalize();
+        _repair();
+        std::vector<Block> old;
+        old.swap(_blocks);
+        size_t used = std::exchange(_used, 0);
+        FreeNode* free = std::exchange(_free, nullptr);
+        try {
+            _relocate(0, _len, spare);
+        } catch (...) {
+            _blocks.swap(old);
+            _used = used;
+            _free = free;
+            throw;
+        }
+        _free = nullptr;
+        _contiguous = true;
+        for (const Block& block : old) {
+            std::allocator<Node>().deallocate(block.nodes, block.capacity);
         }
-        return *this;
     }
 
-    DoublyLinkedList<T>&
-    operator=(std::initializer_list<T> init) {
-        clear();
-        for (const T& value : init) {
-            push_tail(value);
+    /**
+     * Incremental form of compact(): moves segments [first, first + count) into one new block.
+     * The old nodes go to the free list and are reused by later insertions; their memory is
+     * released by the next full compact() or clear(). Returns the first segment not compacted,
+     * so a background job can call compact(next, k) until it returns segments().
+     */
+    uint64_t
+    compact(uint64_t first, uint64_t count) {
+        uint64_t segments = _segments();
+        if (first >= segments) {
+            throw std::out_of_range("first >= segments");
+        }
+        if (count == 0) {
+            return first;
+        }
+        _detach_all();
+        _repair();
+        uint64_t last = first + std::min(count, segments - first);
+        _relocate(first * _size, std::min<uint64_t>(last * _size, _len) - first * _size);
+        _contiguous = first == 0 and last == segments;
+        return last;
+    }
+
+    /**
+     * Bulk algorithms. Work is split by anchor ranges: every thread takes a run of whole
+     * size-long segments and starts walking at its _refs entry, so no thread has to chase
+     * pointers through another thread's part of the list. Segments are visited in storage order,
+     * except by sequenced for_each, which always runs from head to tail.
+     */
+    template <class Policy, class F>
+    void
+    for_each(const Policy& policy, F f) {
+        _detach_all();
+        if (std::is_same_v<Policy, Sequenced> and _reversed) {
+            for (T& value : *this) {
+                f(value);
+            }
+            return;
         }
-        return *this;
+        _for_chunks(policy, [this, &f](unsigned, uint64_t segment, Node* node, uint64_t count) -> void {
+            _walk(segment, node, count, [&f](Node* node) -> void { f(node->value); });
+        });
     }
 
-    friend std::ostream&
-    operator<<(std::ostream& os, const DoublyLinkedList<T>& list) noexcept {
-        os << "head -> ";
-        if (list.head() == nullptr) {
-            os << "nullptr";
-        } else {
+    template <class Policy, class F>
+    void
+    for_each(const Policy& policy, F f) const {
+        if (std::is_same_v<Policy, Sequenced> and _reversed) {
+            for (auto it = cbegin(); it != cend(); ++it) {
+                f(*it);
+            }
+            return;
+        }
+        _for_chunks(policy, [this, &f](unsigned, uint64_t segment, Node* node, uint64_t count) -> void {
+            _walk(segment, node, count, [&f](Node* node) -> void { f(static_cast<const T&>(node->value)); });
+        });
+    }
+
+    // op must be associative and commutative, T must be convertible to U
+    template <class Policy, class U, class BinaryOp>
+    [[nodiscard]] U
+    reduce(const Policy& policy, U init, BinaryOp op) const {
+        if (_len == 0) {
+            return init;
+        }
+        std::vector<U> partials(_threads(policy), init);
+        _for_chunks(policy, [this, &partials, &op](unsigned chunk, uint64_t segment, Node* node,
+                                                   uint64_t count) -> void {
+            U& result = partials[chunk];
+            bool first = chunk != 0;
+            _walk(segment, node, count, [&result, &op, &first](Node* node) -> void {
+                result = first ? static_cast<U>(node->value) : op(std::move(result), node->value);
+                first = false;
+            });
+        });
+
+        U result = std::move(partials[0]);
+        for (size_t i = 1; i < partials.size(); ++i) {
+            result = op(std::move(result), std::move(partials[i]));
+        }
+        return result;
+    }
+
+    // value = f(value) for every element
+    template <class Policy, class F>
+    void
+    transform_inplace(const Policy& policy, F f) {
+        _detach_all();
+        _for_chunks(policy, [this, &f](unsigned, uint64_t segment, Node* node, uint64_t count) -> void {
+            _walk(segment, node, count,
+                  [&f](Node* node) -> void { node->value = f(static_cast<const T&>(node->value)); });
+        });
+    }
+
+    template <class Policy, class Predicate>
+    [[nodiscard]] uint64_t
+    count_if(const Policy& policy, Predicate pred) const {
+        std::vector<uint64_t> counts(_threads(policy), 0);
+        _for_chunks(policy, [this, &counts, &pred](unsigned chunk, uint64_t segment, Node* node,
+                                                   uint64_t count) -> void {
+            uint64_t& result = counts[chunk];
+            _walk(segment, node, count, [&result, &pred](Node* node) -> void {
+                result += pred(static_cast<const T&>(node->value)) ? 1 : 0;
+            });
+        });
+
+        uint64_t result = 0;
+        for (uint64_t count : counts) {
+            result += count;
+        }
+        return result;
+    }
+
+    /**
+     * Lookups and reductions by value. While the nodes are laid out contiguously (after compact()
+     * or construction from a random access range, until a node is inserted, moved, rotated or
+     * taken out of the middle, or appended anywhere but right behind the tail) they run over the
+     * node array without following links, in independent lanes the compiler vectorizes; on x86 in
+     * an AVX2 build if the CPU supports it, with hand-written kernels for find() and count().
+     * Otherwise, or if T is not arithmetic, they walk the list.
+     */
+    // First node holding value, nullptr if none does
+    [[nodiscard]] Node*
+    find(const T& value) const {
+        if constexpr (std::is_arithmetic_v<T>) {
+            if (_contiguous and _len > 0) {
+                Node* nodes = _refs.front();
+                uint64_t pos = _search(nodes, _len, value, _reversed);
+                return pos == _len ? nullptr : nodes + pos;
+            }
+        }
+        for (Node* node = head(); node != nullptr; node = _reversed ? node->prev : node->next) {
+            if (node->value == value) {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] uint64_t
+    count(const T& value) const {
+        if constexpr (std::is_arithmetic_v<T>) {
+            if (_contiguous and _len > 0) {
+                return _count(_refs.front(), _len, value);
+            }
+        }
+        return count_if(seq, [&value](const T& other) -> bool { return other == value; });
+    }
+
+    // T() if the list is empty
+    [[nodiscard]] T
+    min(void) const {
+        return _extreme([](const T& a, const T& b) -> T { return b < a ? b : a; });
+    }
+
+    // T() if the list is empty
+    [[nodiscard]] T
+    max(void) const {
+        return _extreme([](const T& a, const T& b) -> T { return a < b ? b : a; });
+    }
+
+    // Wraps around like T; floating point values are added in an unspecified order
+    [[nodiscard]] T
+    sum(void) const {
+        static_assert(std::is_arithmetic_v<T>, "sum() needs an arithmetic T");
+        auto add = [](const T& a, const T& b) -> T { return static_cast<T>(a + b); };
+        if (_contiguous and _len > 0) {
+            const Node* nodes = _refs.front();
+            return _vectorized([this, nodes, &add]() __attribute__((always_inline)) -> T {
+                return _fold(nodes, _len, T(), add, add);
+            });
+        }
+        return reduce(seq, T(), add);
+    }
+
+    DoublyLinkedList&
+    operator=(const DoublyLinkedList& other) {
+        clear();
+        for (const T& value : other) {
+            push_tail(value);
+        }
+        return *this;
+    }
+
+    DoublyLinkedList&
+    operator=(std::initializer_list<T> init) {
+        clear();
+        for (const T& value : init) {
+            push_tail(value);
+        }
+        return *this;
+    }
+
+    friend std::ostream&
+    operator<<(std::ostream& os, const DoublyLinkedList& list) noexcept {
+        os << "head -> ";
+        if (list.head() == nullptr) {
+            os << "nullptr";
+        } else {
             os << list.head()->value;
             for (auto it = ++list.cbegin(); it != list.cend(); ++it) {
                 os << " <-> " << *it;
@@ -395,7 +1059,7 @@ class DoublyLinkedList {
     }
 
     friend std::ofstream&
-    operator<<(std::ofstream& ofs, const DoublyLinkedList<T>& list) noexcept {
+    operator<<(std::ofstream& ofs, const DoublyLinkedList& list) noexcept {
         for (auto it = list.cbegin(); it != list.cend(); ++it) {
             ofs << *it << std::endl;
         }
@@ -404,7 +1068,7 @@ class DoublyLinkedList {
 
     // Enter ' ' to stop input
     friend std::istream&
-    operator>>(std::istream& is, DoublyLinkedList<T>& list) {
+    operator>>(std::istream& is, DoublyLinkedList& list) {
         assert(list.from_string != nullptr
                and "Please provide like so: list.from_string = [](std::string line) -> T {...}");
         std::string line;
@@ -415,7 +1079,7 @@ class DoublyLinkedList {
     }
 
     friend std::ifstream&
-    operator>>(std::ifstream& ifs, DoublyLinkedList<T>& list) {
+    operator>>(std::ifstream& ifs, DoublyLinkedList& list) {
         assert(list.from_string != nullptr
                and "Please provide like so: list.from_string = [](std::string line) -> T {...}");
         std::string line;
@@ -425,11 +1089,62 @@ class DoublyLinkedList {
         return ifs;
     }
 
+    /**
+     * Asynchronous form of operator>> (std::ifstream&): appends one value per line until the end
+     * of the input, in order. A background thread reads blocks of ingest_block bytes cut at line
+     * ends, parsers threads (0 = hardware_concurrency - 1) parse them with from_string into
+     * chains of nodes, one exactly sized block per chain, and whichever parser completes the next
+     * chain in order splices the ready ones onto the tail and appends their anchors, so
+     * from_string must be safe to call from several threads at once. Neither the list nor the
+     * input may be used until the returned future, of the number of values appended, is ready.
+     * If reading or parsing throws, the future rethrows and the chains spliced so far stay.
+     */
+    std::future<uint64_t>
+    ingest(std::istream& is, unsigned parsers = 0) {
+        return _ingest(
+            [&is](char* buffer, size_t size) -> size_t {
+                is.read(buffer, static_cast<std::streamsize>(size));
+                if (is.bad()) {
+                    throw std::runtime_error("cannot read the input stream");
+                }
+                return static_cast<size_t>(is.gcount());
+            },
+            parsers);
+    }
+
+    // Reads the file descriptor fd, which stays open
+    std::future<uint64_t>
+    ingest(int fd, unsigned parsers = 0) {
+        return _ingest(
+            [fd](char* buffer, size_t size) -> size_t {
+                ssize_t n;
+                while ((n = ::read(fd, buffer, size)) == -1 and errno == EINTR) {
+                }
+                if (n == -1) {
+                    throw std::system_error(errno, std::generic_category(), "cannot read the file descriptor");
+                }
+                return static_cast<size_t>(n);
+            },
+            parsers);
+    }
+
+    // Bytes read at once by ingest
+    static constexpr size_t ingest_block = 1 << 20;
+
     [[nodiscard]] constexpr bool
-    operator==(const DoublyLinkedList<T>& other) const noexcept {
+    operator==(const DoublyLinkedList& other) const noexcept {
         if (this->_len != other._len) {
             return false;
         }
+        if constexpr (std::is_arithmetic_v<T>) {
+            // Both in the same storage order, see find
+            if (_contiguous and other._contiguous and _reversed == other._reversed and _len > 0) {
+                const Node *nodes = _refs.front(), *others = other._refs.front();
+                return _vectorized([this, nodes, others]() __attribute__((always_inline)) -> bool {
+                    return _equal(nodes, others, _len);
+                });
+            }
+        }
         for (auto it1 = this->cbegin(), it2 = other.cbegin(); it1 != other.cend(); ++it1, ++it2) {
             if (*it1 != *it2) {
                 return false;
@@ -439,10 +1154,81 @@ class DoublyLinkedList {
     }
 
     [[nodiscard]] constexpr bool
-    operator!=(const DoublyLinkedList<T>& other) const noexcept {
+    operator!=(const DoublyLinkedList& other) const noexcept {
         return !(*this == other);
     }
 
+    /**
+     * Fingerprints. With fingerprint(true) the list keeps a polynomial hash modulo 2^61 - 1 of
+     * every size-long segment, rolled along by push, pop and insert within the O(length / size)
+     * anchor upkeep they do anyway. Operations on many or unknown positions (see snapshot())
+     * drop them, to be recomputed in O(length) by their next use; so do values assigned through
+     * a Node* or an iterator, which the list cannot see: call fingerprint(true) again after such
+     * writes. diff() then compares in O(length / size) alone; operator== always compares the
+     * values, since a stale fingerprint would make it report equal lists as different.
+     */
+    void
+    fingerprint(bool enable) {
+        static_assert(_hashable, "fingerprints need std::hash<T>");
+        _fingerprinted = enable;
+        _hashes.clear();
+        if (not enable) {
+            _hashes.shrink_to_fit();
+            _powers = {};
+        }
+    }
+
+    [[nodiscard]] constexpr bool
+    fingerprinted(void) const noexcept {
+        return _fingerprinted;
+    }
+
+    /**
+     * Position ranges [begin, end) of the size-long segments, counted from the head, whose values
+     * differ from the values of other at the same positions; adjacent ranges are merged and a
+     * difference in length counts as a differing tail. Compares fingerprints if both lists keep
+     * them with the same size and storage order, and so may miss a change with probability
+     * about size / 2^61 per segment; otherwise compares the values.
+     */
+    [[nodiscard]] std::vector<std::pair<uint64_t, uint64_t>>
+    diff(const DoublyLinkedList& other) const {
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        auto add = [&ranges](uint64_t begin, uint64_t end) -> void {
+            if (not ranges.empty() and ranges.back().second == begin) {
+                ranges.back().second = end;
+            } else {
+                ranges.emplace_back(begin, end);
+            }
+        };
+        uint64_t len = std::max(_len, other._len), segments = len == 0 ? 0 : (len - 1) / _size + 1;
+        if (_fingerprinted and other._fingerprinted and _size == other._size and _reversed == other._reversed
+            and (not _reversed or _len == other._len)) {
+            const std::vector<uint64_t>&hashes = _fingerprint(), &others = other._fingerprint();
+            for (uint64_t k = 0; k < segments; ++k) {
+                // From the head, which is the last segment in storage order if reversed
+                uint64_t i = _reversed ? segments - 1 - k : k;
+                if (i >= hashes.size() or i >= others.size() or hashes[i] != others[i]
+                    or (i + 1 == segments and _len != other._len)) {
+                    uint64_t begin = i * _size, end = std::min<uint64_t>(begin + _size, len);
+                    _reversed ? add(len - end, len - begin) : add(begin, end);
+                }
+            }
+            return ranges;
+        }
+        auto it1 = cbegin(), it2 = other.cbegin();
+        for (uint64_t begin = 0; begin < len; begin += _size) {
+            uint64_t end = std::min<uint64_t>(begin + _size, len);
+            bool differs = end > _len or end > other._len;
+            for (uint64_t pos = begin; pos < std::min({end, _len, other._len}); ++pos, ++it1, ++it2) {
+                differs = differs or *it1 != *it2;
+            }
+            if (differs) {
+                add(begin, end);
+            }
+        }
+        return ranges;
+    }
+
     [[nodiscard]] constexpr bool
     empty(void) const noexcept {
         return _len == 0;
@@ -455,12 +1241,12 @@ class DoublyLinkedList {
 
     [[nodiscard]] constexpr auto
     head(void) const noexcept {
-        return _refs.front();
+        return _reversed ? _refs.back() : _refs.front();
     }
 
     [[nodiscard]] constexpr auto
     tail(void) const noexcept {
-        return _refs.back();
+        return _reversed ? _refs.front() : _refs.back();
     }
 
     [[nodiscard]] constexpr auto
@@ -468,269 +1254,2262 @@ class DoublyLinkedList {
         return _size;
     }
 
-    class Iterator {
-        Node* _node;
+    [[nodiscard]] Stats
+    stats(void) const noexcept {
+        Stats stats;
+#ifdef DOUBLY_LINKED_LIST_STATS
+        for (uint64_t Stats::*counter : {&Stats::hops, &Stats::shifted, &Stats::allocations, &Stats::frees,
+                                         &Stats::blocks, &Stats::reallocations, &Stats::comparisons,
+                                         &Stats::repairs, &Stats::detached}) {
+            stats.*counter = __atomic_load_n(&(_stats.*counter), __ATOMIC_RELAXED);
+        }
+        for (size_t operation = 0; operation < Stats::operations; ++operation) {
+            for (size_t bucket = 0; bucket < Stats::buckets; ++bucket) {
+                const uint64_t& counter = _stats.latency[operation][bucket];
+                stats.latency[operation][bucket] = __atomic_load_n(&counter, __ATOMIC_RELAXED);
+            }
+        }
+#endif
+        return stats;
+    }
 
-      public:
-        using iterator_category = std::bidirectional_iterator_tag;
-        using difference_type = std::ptrdiff_t;
-        using value_type = T;
-        using pointer = T*;
-        using reference = T&;
+    // Bytes held by the list
+    struct MemoryUsage {
+        // Nodes holding values
+        uint64_t nodes;
+        // Used part of the _refs anchor index
+        uint64_t index;
+        // Spare _refs capacity, pooled nodes not holding values and pool bookkeeping
+        uint64_t slack;
+    };
 
-        explicit Iterator(Node* node) : _node{node} {}
+    [[nodiscard]] MemoryUsage
+    memory_usage(void) const noexcept {
+        uint64_t pooled = _pooled();
+        return {_len * sizeof(Node), _refs.size() * sizeof(Node*),
+                (_refs.capacity() - _refs.size()) * sizeof(Node*) + (pooled - _len) * sizeof(Node)
+                    + _blocks.capacity() * sizeof(Block)};
+    }
 
-        [[nodiscard]] constexpr reference
-        operator*() const noexcept {
-            return _node->value;
+    // Sets up the anchor index and the node pool for length values, so that growing up to it allocates nothing
+    void
+    reserve(uint64_t length) {
+        _refs.reserve(_anchors(length));
+        uint64_t pooled = _pooled();
+        if (length > pooled) {
+            _grow(length - pooled);
         }
+    }
 
-        constexpr Iterator&
-        operator++() noexcept {
-            _node = _node->next;
-            return *this;
-        }
+    /**
+     * Gives back everything not needed for the current length: the anchor index is trimmed and
+     * the nodes are compacted into one exactly sized block. Invalidates every Node* handed out before.
+     */
+    void
+    shrink_to_fit(void) {
+        compact();
+        _refs.shrink_to_fit();
+    }
 
-        constexpr Iterator
-        operator++(int) noexcept {
-            Iterator tmp = *this;
-            ++(*this);
-            return tmp;
-        }
+    void
+    reset_stats(void) noexcept {
+#ifdef DOUBLY_LINKED_LIST_STATS
+        _stats = {};
+#endif
+    }
 
-        constexpr Iterator&
-        operator--() noexcept {
-            _node = _node->prev;
-            return *this;
-        }
+  private:
+    struct SnapshotState;
 
-        constexpr Iterator
-        operator--(int) noexcept {
-            Iterator tmp = *this;
-            --(*this);
-            return tmp;
+  public:
+    // Immutable view returned by snapshot(), may be read by other threads while the list changes
+    class Snapshot {
+      public:
+        [[nodiscard]] uint64_t
+        length(void) const noexcept {
+            return _state->len;
         }
 
-        [[nodiscard]] constexpr bool
-        operator==(const Iterator& other) const noexcept {
-            return _node == other._node;
+        [[nodiscard]] bool
+        empty(void) const noexcept {
+            return _state->len == 0;
         }
 
-        [[nodiscard]] constexpr bool
-        operator!=(const Iterator& other) const noexcept {
-            return !(*this == other);
+        [[nodiscard]] T
+        at(uint64_t pos) const {
+            if (pos >= _state->len) {
+                throw std::out_of_range("pos >= length");
+            }
+            if (_state->reversed) {
+                pos = _state->len - 1 - pos;
+            }
+            std::shared_lock lock(_state->mutex);
+            const std::vector<T>& values = _state->detached[pos / _state->size];
+            if (not values.empty()) {
+                return values[pos % _state->size];
+            }
+            Node* node = _state->anchors[pos / _state->size];
+            for (S i = 0; i < pos % _state->size; ++i) {
+                node = node->next;
+            }
+            return node->value;
+        }
+
+        // Calls f(value) from head to tail, one segment copied out at a time
+        template <class F>
+        void
+        for_each(F f) const {
+            std::vector<T> values;
+            uint64_t segments = _state->anchors.size();
+            for (uint64_t i = 0; i < segments; ++i) {
+                _state->copy(_state->reversed ? segments - 1 - i : i, values);
+                if (_state->reversed) {
+                    std::for_each(values.crbegin(), values.crend(), f);
+                } else {
+                    std::for_each(values.cbegin(), values.cend(), f);
+                }
+            }
         }
-    };
 
-    Iterator
-    begin() const {
-        return Iterator(_refs.front());
-    }
+      private:
+        friend class DoublyLinkedList;
 
-    Iterator
-    end() const {
-        return Iterator(nullptr);
+        explicit Snapshot(std::shared_ptr<const SnapshotState> state) : _state(std::move(state)) {}
+
+        std::shared_ptr<const SnapshotState> _state;
+    };
+
+    /**
+     * Point-in-time view of the list in O(length / size). The snapshot records the anchors and
+     * keeps reading the list's own nodes; whenever the list is about to change a segment that a
+     * snapshot still shares, it copies that segment out to the snapshot first, so a snapshot
+     * costs memory in proportion to the segments changed since. Positional operations (push,
+     * pop, insert, at any position) copy out at most the one segment they touch. Operations on
+     * many or unknown positions (node handle operations, rotate, sort, compact,
+     * transform_inplace, non-const for_each, clear) copy out everything still shared. Values
+     * assigned through a Node* or an iterator bypass this and show up in snapshots sharing them.
+     */
+    [[nodiscard]] Snapshot
+    snapshot(void) {
+        _repair();
+        auto state = std::make_shared<SnapshotState>();
+        uint64_t segments = _segments();
+        state->anchors.resize(segments);
+        for (uint64_t i = 0; i < segments; ++i) {
+            state->anchors[i] = _segment(i);
+        }
+        state->len = _len;
+        state->size = _size;
+        state->reversed = _reversed;
+        state->spans.assign(segments + 1, 0);
+        for (uint64_t i = 1; i <= segments; ++i) {
+            state->spans[i] += static_cast<int64_t>(state->count(i - 1));
+            if (uint64_t parent = i + (i & (~i + 1)); parent <= segments) {
+                state->spans[parent] += state->spans[i];
+            }
+        }
+        state->detached.resize(segments);
+        state->shared = segments;
+        if (segments > 0) {
+            _snapshots.push_back(state);
+        }
+        return Snapshot(std::move(state));
     }
 
-    class ConstIterator {
-        Node* _node;
+    /**
+     * Node by node iterators: Iterator and ConstIterator run from head to tail, ReverseIterator
+     * and ConstReverseIterator from tail to head. After reverse() all of them follow the links
+     * in storage order the other way round.
+     */
+    template <bool Const, bool Backward>
+    class BasicIterator {
+        Node* _node = nullptr;
+        // Follow prev for next, see reverse
+        bool _flipped = false;
 
       public:
         using iterator_category = std::bidirectional_iterator_tag;
         using difference_type = std::ptrdiff_t;
         using value_type = T;
-        using pointer = T*;
-        using reference = const T&;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
 
-        explicit ConstIterator(Node* node) : _node{node} {}
+        BasicIterator() = default;
+
+        explicit BasicIterator(Node* node, bool flipped = false) : _node{node}, _flipped{flipped} {}
 
         [[nodiscard]] constexpr reference
         operator*() const noexcept {
             return _node->value;
         }
 
-        constexpr ConstIterator&
+        [[nodiscard]] constexpr pointer
+        operator->() const noexcept {
+            return &_node->value;
+        }
+
+        constexpr BasicIterator&
         operator++() noexcept {
-            _node = _node->next;
+            _node = _flipped != Backward ? _node->prev : _node->next;
+            _prefetch_hop(_node, _flipped != Backward);
             return *this;
         }
 
-        constexpr ConstIterator
+        constexpr BasicIterator
         operator++(int) noexcept {
-            ConstIterator tmp = *this;
+            BasicIterator tmp = *this;
             ++(*this);
             return tmp;
         }
 
-        constexpr ConstIterator&
+        constexpr BasicIterator&
         operator--() noexcept {
-            _node = _node->prev;
+            _node = _flipped != Backward ? _node->next : _node->prev;
+            _prefetch_hop(_node, _flipped == Backward);
             return *this;
         }
 
-        constexpr ConstIterator
+        constexpr BasicIterator
         operator--(int) noexcept {
-            ConstIterator tmp = *this;
+            BasicIterator tmp = *this;
             --(*this);
             return tmp;
         }
 
         [[nodiscard]] constexpr bool
-        operator==(const ConstIterator& other) const noexcept {
+        operator==(const BasicIterator& other) const noexcept {
             return _node == other._node;
         }
 
         [[nodiscard]] constexpr bool
-        operator!=(const ConstIterator& other) const noexcept {
+        operator!=(const BasicIterator& other) const noexcept {
             return !(*this == other);
         }
     };
 
+    using Iterator = BasicIterator<false, false>;
+    using ConstIterator = BasicIterator<true, false>;
+    using ReverseIterator = BasicIterator<false, true>;
+    using ConstReverseIterator = BasicIterator<true, true>;
+
+    Iterator
+    begin() const {
+        return Iterator(head(), _reversed);
+    }
+
+    Iterator
+    end() const {
+        return Iterator(nullptr, _reversed);
+    }
+
     ConstIterator
     cbegin() const {
-        return ConstIterator(_refs.front());
+        return ConstIterator(head(), _reversed);
     }
 
     ConstIterator
     cend() const {
-        return ConstIterator(nullptr);
+        return ConstIterator(nullptr, _reversed);
+    }
+
+    ReverseIterator
+    rbegin() const {
+        return ReverseIterator(tail(), _reversed);
+    }
+
+    ReverseIterator
+    rend() const {
+        return ReverseIterator(nullptr, _reversed);
+    }
+
+    ConstReverseIterator
+    crbegin() const {
+        return ConstReverseIterator(tail(), _reversed);
+    }
+
+    ConstReverseIterator
+    crend() const {
+        return ConstReverseIterator(nullptr, _reversed);
     }
 
-    class ReverseIterator {
-        Node* _node;
+    // Consecutive values from head to tail, see slice(), segments() and chunks()
+    using Slice = DoublyLinkedListSlice<Iterator>;
+
+    /**
+     * The list as a range of its segments, see segments(). Dereferencing yields the Slice of a
+     * segment, built from its anchors in O(1).
+     */
+    class Segments : public DoublyLinkedListView<Segments> {
+        const DoublyLinkedList* _list = nullptr;
 
       public:
-        using iterator_category = std::bidirectional_iterator_tag;
-        using difference_type = std::ptrdiff_t;
-        using value_type = T;
-        using pointer = T*;
-        using reference = T&;
+        class SegmentIterator {
+            const DoublyLinkedList* _list = nullptr;
+            uint64_t _i = 0;
+
+          public:
+            // Segments are made on the fly, so dereferencing yields a Slice rather than a reference
+            using iterator_category = std::input_iterator_tag;
+            using iterator_concept = std::bidirectional_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = Slice;
+            using pointer = void;
+            using reference = Slice;
+
+            SegmentIterator() = default;
+
+            SegmentIterator(const DoublyLinkedList* list, uint64_t i) : _list{list}, _i{i} {}
+
+            [[nodiscard]] reference
+            operator*() const noexcept {
+                return _list->_slice(_i);
+            }
 
-        explicit ReverseIterator(Node* node) : _node{node} {}
+            SegmentIterator&
+            operator++() noexcept {
+                ++_i;
+                return *this;
+            }
 
-        [[nodiscard]] constexpr reference
-        operator*() const noexcept {
-            return _node->value;
-        }
+            SegmentIterator
+            operator++(int) noexcept {
+                SegmentIterator tmp = *this;
+                ++(*this);
+                return tmp;
+            }
 
-        constexpr ReverseIterator&
-        operator++() noexcept {
-            _node = _node->prev;
-            return *this;
-        }
+            SegmentIterator&
+            operator--() noexcept {
+                --_i;
+                return *this;
+            }
 
-        constexpr ReverseIterator
-        operator++(int) noexcept {
-            ReverseIterator tmp = *this;
-            ++(*this);
-            return tmp;
+            SegmentIterator
+            operator--(int) noexcept {
+                SegmentIterator tmp = *this;
+                --(*this);
+                return tmp;
+            }
+
+            [[nodiscard]] bool
+            operator==(const SegmentIterator& other) const noexcept {
+                return _i == other._i;
+            }
+
+            [[nodiscard]] bool
+            operator!=(const SegmentIterator& other) const noexcept {
+                return !(*this == other);
+            }
+        };
+
+        Segments() = default;
+
+        explicit Segments(const DoublyLinkedList* list) : _list{list} {}
+
+        [[nodiscard]] SegmentIterator
+        begin() const noexcept {
+            return SegmentIterator(_list, 0);
         }
 
-        constexpr ReverseIterator&
-        operator--() noexcept {
-            _node = _node->next;
-            return *this;
+        [[nodiscard]] SegmentIterator
+        end() const noexcept {
+            return SegmentIterator(_list, size());
         }
 
-        constexpr ReverseIterator
-        operator--(int) noexcept {
-            ReverseIterator tmp = *this;
-            --(*this);
-            return tmp;
+        [[nodiscard]] uint64_t
+        size() const noexcept {
+            return _list == nullptr ? 0 : _list->_segments();
         }
 
-        [[nodiscard]] constexpr bool
-        operator==(const ReverseIterator& other) const noexcept {
-            return _node == other._node;
+        [[nodiscard]] bool
+        empty() const noexcept {
+            return size() == 0;
         }
 
-        [[nodiscard]] constexpr bool
-        operator!=(const ReverseIterator& other) const noexcept {
-            return !(*this == other);
+        // The i-th segment from the head, O(1)
+        [[nodiscard]] Slice
+        operator[](uint64_t i) const noexcept {
+            return _list->_slice(i);
         }
     };
 
-    ReverseIterator
-    rbegin() const {
-        return ReverseIterator(_refs.back());
-    }
+    /**
+     * The list as a range of chunks of n values from the head, see chunks(). The iterator steps
+     * from the end of one chunk to the next, so a pass over all of them is O(length); operator[]
+     * opens a chunk through slice().
+     */
+    class Chunks : public DoublyLinkedListView<Chunks> {
+        const DoublyLinkedList* _list = nullptr;
+        uint64_t _n = 1;
 
-    ReverseIterator
-    rend() const {
-        return ReverseIterator(nullptr);
-    }
+      public:
+        class ChunkIterator {
+            const DoublyLinkedList* _list = nullptr;
+            uint64_t _n = 1;
+            uint64_t _i = 0;
+            // Values of chunk _i
+            Iterator _first;
+            Iterator _last;
+
+            // Values in chunk _i, 0 past the last one
+            [[nodiscard]] uint64_t
+            _count(void) const noexcept {
+                uint64_t len = _list->length();
+                return _i * _n >= len ? 0 : std::min(_n, len - _i * _n);
+            }
 
-    class ConstReverseIterator {
-        Node* _node;
+          public:
+            // Chunks are made on the fly, so dereferencing yields a Slice rather than a reference
+            using iterator_category = std::input_iterator_tag;
+            using iterator_concept = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = Slice;
+            using pointer = void;
+            using reference = Slice;
 
-      public:
-        using iterator_category = std::bidirectional_iterator_tag;
-        using difference_type = std::ptrdiff_t;
-        using value_type = T;
-        using pointer = T*;
-        using reference = const T&;
+            ChunkIterator() = default;
 
-        explicit ConstReverseIterator(Node* node) : _node{node} {}
+            ChunkIterator(const DoublyLinkedList* list, uint64_t n, uint64_t i, Iterator first)
+                : _list{list}, _n{n}, _i{i}, _first{first}, _last{std::next(first, _count())} {}
 
-        [[nodiscard]] constexpr reference
-        operator*() const noexcept {
-            return _node->value;
-        }
+            [[nodiscard]] reference
+            operator*() const noexcept {
+                return Slice(_first, _last, _count());
+            }
 
-        constexpr ConstReverseIterator&
-        operator++() noexcept {
-            _node = _node->prev;
-            return *this;
-        }
+            ChunkIterator&
+            operator++() noexcept {
+                ++_i;
+                _first = _last;
+                std::advance(_last, _count());
+                return *this;
+            }
 
-        constexpr ConstReverseIterator
-        operator++(int) noexcept {
-            ConstReverseIterator tmp = *this;
-            ++(*this);
-            return tmp;
+            ChunkIterator
+            operator++(int) noexcept {
+                ChunkIterator tmp = *this;
+                ++(*this);
+                return tmp;
+            }
+
+            [[nodiscard]] bool
+            operator==(const ChunkIterator& other) const noexcept {
+                return _i == other._i;
+            }
+
+            [[nodiscard]] bool
+            operator!=(const ChunkIterator& other) const noexcept {
+                return !(*this == other);
+            }
+        };
+
+        Chunks() = default;
+
+        Chunks(const DoublyLinkedList* list, uint64_t n) : _list{list}, _n{n} {}
+
+        [[nodiscard]] ChunkIterator
+        begin() const noexcept {
+            return _list == nullptr ? ChunkIterator() : ChunkIterator(_list, _n, 0, _list->begin());
         }
 
-        constexpr ConstReverseIterator&
-        operator--() noexcept {
-            _node = _node->next;
-            return *this;
+        [[nodiscard]] ChunkIterator
+        end() const noexcept {
+            return _list == nullptr ? ChunkIterator() : ChunkIterator(_list, _n, size(), _list->end());
         }
 
-        constexpr ConstReverseIterator
-        operator--(int) noexcept {
-            ConstReverseIterator tmp = *this;
-            --(*this);
-            return tmp;
+        [[nodiscard]] uint64_t
+        size() const noexcept {
+            return _list == nullptr ? 0 : (_list->length() + _n - 1) / _n;
         }
 
-        [[nodiscard]] constexpr bool
-        operator==(const ConstReverseIterator& other) const noexcept {
-            return _node == other._node;
+        [[nodiscard]] bool
+        empty() const noexcept {
+            return size() == 0;
         }
 
-        [[nodiscard]] constexpr bool
-        operator!=(const ConstReverseIterator& other) const noexcept {
-            return !(*this == other);
+        // The i-th chunk from the head, O(size + n)
+        [[nodiscard]] Slice
+        operator[](uint64_t i) const {
+            return _list->slice(i * _n, std::min(_n, _list->length() - i * _n));
         }
     };
 
-    ConstReverseIterator
-    crbegin() const {
-        return ConstReverseIterator(_refs.back());
+    /**
+     * Segmented view: the list as a range of its size-long segments, each a Slice of its values,
+     * from head to tail. Every segment starts at an anchor, so an algorithm (or a job of its own
+     * thread) can start at any segment in O(1) instead of walking there. Segments are cut in
+     * storage order, so the one shorter segment is the last one, or the first one after
+     * reverse(). Any change to the list but assigning values invalidates the view.
+     */
+    [[nodiscard]] Segments
+    segments(void) const {
+        _repair();
+        return Segments(this);
     }
 
-    ConstReverseIterator
-    crend() const {
-        return ConstReverseIterator(nullptr);
+    /**
+     * The list as a range of chunks of n consecutive values from the head, each a Slice, the last
+     * one shorter unless n divides the length. Unlike segments() the chunks need not start at
+     * anchors, so n is free and reverse() does not move the short one. Any change to the list but
+     * assigning values invalidates the view.
+     */
+    [[nodiscard]] Chunks
+    chunks(uint64_t n) const {
+        if (n == 0) {
+            throw std::invalid_argument("n == 0");
+        }
+        return Chunks(this, n);
+    }
+
+    // Values [pos, pos + len) as a range, opened in O(size + length / size) from the anchors
+    [[nodiscard]] Slice
+    slice(uint64_t pos, uint64_t len) const {
+        if (pos > _len or len > _len - pos) {
+            throw std::out_of_range("pos + len > length");
+        }
+        Iterator first = pos == _len ? end() : Iterator(_at(_reversed ? _len - 1 - pos : pos), _reversed);
+        Iterator last = first;
+        if (len <= _size) {
+            std::advance(last, len);
+        } else if (pos + len < _len) {
+            last = Iterator(_at(_reversed ? _len - 1 - pos - len : pos + len), _reversed);
+        } else {
+            last = end();
+        }
+        return Slice(first, last, len);
     }
 
     // Function to work with input operator
     std::function<T(const std::string&)> from_string = nullptr;
 
   private:
+    // Records the latency of one call into its histogram when it goes out of scope
+    struct Timer {
+#ifdef DOUBLY_LINKED_LIST_STATS
+        uint64_t* histogram;
+        std::chrono::steady_clock::time_point start;
+
+        ~Timer() {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            size_t bucket = 0;
+            for (auto count = ns.count(); count > 1 and bucket + 1 < Stats::buckets; count >>= 1) {
+                ++bucket;
+            }
+            __atomic_fetch_add(&histogram[bucket], 1, __ATOMIC_RELAXED);
+        }
+#endif
+    };
+
+    [[nodiscard]] Timer
+    _time([[maybe_unused]] typename Stats::Operation operation) const noexcept {
+#ifdef DOUBLY_LINKED_LIST_STATS
+        return Timer{_stats.latency[operation].data(), std::chrono::steady_clock::now()};
+#else
+        return {};
+#endif
+    }
+
+    // Number of _refs entries for a list of length values
+    [[nodiscard]] uint64_t
+    _anchors(uint64_t length) const noexcept {
+        return length < 2 ? 2 : 2 + (length - 2) / _size;
+    }
+
+    // Recomputes _refs from the links, into storage of exactly the needed size
+    void
+    _rebuild_refs(void) const {
+        _dirty = false;
+        Node* node = _refs.front();
+        if (node == nullptr) {
+            _refs = {nullptr, nullptr};
+            return;
+        }
+        std::vector<Node*> refs;
+        refs.reserve(_anchors(_len));
+        for (uint64_t i = 0; node->next != nullptr; ++i, node = node->next) {
+            if (i % _size == 0) {
+                refs.push_back(node);
+            }
+        }
+        if (refs.empty()) {
+            refs.push_back(node);
+        }
+        refs.push_back(node);
+        _refs.swap(refs);
+    }
+
+    void
+    _repair(void) const {
+        if (_dirty) {
+            DOUBLY_LINKED_LIST_COUNT(repairs, 1);
+            _rebuild_refs();
+        }
+    }
+
+    /**
+     * Node for storage position pos, not linked in yet. Snapshots learn of it only once it is
+     * built, so an allocation or a copy of T that throws leaves them as they were.
+     */
+    template <class U>
+    Node*
+    _make_node(uint64_t pos, Node* prev, U&& value, Node* next) {
+        Node* node = _new_node(prev, std::forward<U>(value), next);
+        try {
+            _snapshot_insert(pos);
+        } catch (...) {
+            _delete_node(node);
+            throw;
+        }
+        return node;
+    }
+
+    // The physical operations below work in storage order: front = _refs.front(), back = _refs.back()
+    template <class U>
+    Node*
+    _push_back(U&& value) {
+        // Still contiguous if the node was carved right behind the last one, see compact
+        bool contiguous = _contiguous;
+        Node* new_node = _make_node(_len, _refs.back(), std::forward<U>(value), nullptr);
+        ++_len;
+        if (_refs.front() == nullptr) {
+            return _refs.front() = _refs.back() = new_node;
+        }
+        _contiguous = contiguous and new_node == _refs.front() + (_len - 1);
+        _refs.back()->next = new_node;
+        if (not _dirty and _len > 2 and (_len - 2) % _size == 0) {
+            _push_ref(new_node);
+        } else {
+            _refs.back() = new_node;
+        }
+        _hash_push(new_node->value);
+        return new_node;
+    }
+
+    template <class U>
+    Node*
+    _push_front(U&& value) {
+        Node* new_node = _make_node(0, nullptr, std::forward<U>(value), _refs.front());
+        ++_len;
+        if (_refs.front() == nullptr) {
+            return _refs.front() = _refs.back() = new_node;
+        }
+        _refs.front()->prev = new_node;
+        if (_dirty) {
+            _hashes.clear();
+            return _refs.front() = _refs.front()->prev;
+        }
+        for (size_t i = 0; i < _refs.size() - 1; ++i) {
+            _refs[i] = _refs[i]->prev;
+        }
+        DOUBLY_LINKED_LIST_COUNT(shifted, _refs.size() - 1);
+        if (_len > 2 and (_len - 2) % _size == 0) {
+            _refs.back() = _refs.back()->prev;
+            _push_ref(_refs.back()->next);
+        }
+        _hash_insert(0);
+        return _refs.front();
+    }
+
+    // 0 < pos < _len
+    template <class U>
+    Node*
+    _insert(uint64_t pos, U&& value) {
+        Node* node = _at(pos);
+        node->prev = node->prev->next = _make_node(pos, node->prev, std::forward<U>(value), node);
+        for (size_t i = (pos % _size ? 1 : 0) + pos / _size; i < _refs.size() - 1; ++i) {
+            _refs[i] = _refs[i]->prev;
+            DOUBLY_LINKED_LIST_COUNT(shifted, 1);
+        }
+        ++_len;
+        if (_len > 2 and (_len - 2) % _size == 0) {
+            _refs.back() = _refs.back()->prev;
+            _push_ref(_refs.back()->next);
+        }
+        _hash_insert(pos);
+        return node->prev;
+    }
+
+    T
+    _pop_back(void) noexcept {
+        if (_refs.front() == nullptr) {
+            return T();
+        }
+        _snapshot_erase(_len - 1);
+        _hash_pop(_refs.back()->value);
+        --_len;
+        T result = _refs.back()->value;
+
+        if (_len == 0) {
+            // Nothing can refer to the pool anymore, give it back
+            clear();
+        } else {
+            _refs.back() = _refs.back()->prev;
+            _delete_node(_refs.back()->next);
+            _refs.back()->next = nullptr;
+            if (not _dirty and _len > 1 and (_len - 1) % _size == 0) {
+                _pop_ref();
+            }
+        }
+        return result;
+    }
+
+    T
+    _pop_front(void) noexcept {
+        if (_refs.front() == nullptr) {
+            return T();
+        }
+        _snapshot_erase(0);
+        --_len;
+        T result = _refs.front()->value;
+
+        if (_len == 0) {
+            // Nothing can refer to the pool anymore, give it back
+            clear();
+        } else {
+            _refs.front() = _refs.front()->next;
+            _delete_node(_refs.front()->prev);
+            _refs.front()->prev = nullptr;
+            if (not _dirty) {
+                for (uint64_t i = 1; i < _refs.size() - 1; ++i) {
+                    _refs[i] = _refs[i]->next;
+                }
+                DOUBLY_LINKED_LIST_COUNT(shifted, _refs.size() - 2);
+                if (_len > 1 and (_len - 1) % _size == 0) {
+                    _pop_ref();
+                }
+                _hash_erase(0);
+            } else {
+                _hashes.clear();
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]] Node*
+    _at(uint64_t pos) const {
+        _repair();
+
+        Node* node = _refs[pos / _size];
+        // Lands on the target if the segment is laid out contiguously, see compact()
+        _prefetch(_ahead(node, pos % _size));
+        DOUBLY_LINKED_LIST_COUNT(hops, pos % _size);
+        for (S i = 0; i < pos % _size; ++i) {
+            node = node->next;
+        }
+        return node;
+    }
+
+    // Node at pos, walking from the closer of the anchors around it (which must be exact)
+    [[nodiscard]] Node*
+    _locate(uint64_t pos) const noexcept {
+        uint64_t offset = pos % _size, segment = pos / _size;
+        bool anchored = segment + 1 < _refs.size() - 1;
+        uint64_t back = anchored ? _size - offset : _len - 1 - pos;
+        if (offset <= back) {
+            Node* node = _refs[segment];
+            DOUBLY_LINKED_LIST_COUNT(hops, offset);
+            for (; offset > 0; --offset) {
+                node = node->next;
+            }
+            return node;
+        }
+        Node* node = anchored ? _refs[segment + 1] : _refs.back();
+        DOUBLY_LINKED_LIST_COUNT(hops, back);
+        for (; back > 0; --back) {
+            node = node->prev;
+        }
+        return node;
+    }
+
+    // Node at pos, walking from the closer end
+    [[nodiscard]] Node*
+    _walk_to(uint64_t pos) const noexcept {
+        DOUBLY_LINKED_LIST_COUNT(hops, std::min(pos, _len - 1 - pos));
+        Node* node;
+        if (pos <= _len - 1 - pos) {
+            for (node = _refs.front(); pos > 0; --pos) {
+                node = node->next;
+            }
+        } else {
+            for (node = _refs.back(), pos = _len - 1 - pos; pos > 0; --pos) {
+                node = node->prev;
+            }
+        }
+        return node;
+    }
+
+    // Turns a reversed list into the same sequence in storage order, O(length)
+    void
+    _normalize(void) {
+        if (not _reversed) {
+            return;
+        }
+        for (Node* node = _refs.front(); node != nullptr; node = node->prev) {
+            std::swap(node->prev, node->next);
+        }
+        std::swap(_refs.front(), _refs.back());
+        _reversed = false;
+        _contiguous = false;
+        _dirty = true;
+        _hashes.clear();
+        _repair();
+    }
+
+    // Takes node out of the links, keeping head and tail
+    void
+    _unlink(Node* node) noexcept {
+        (node->prev != nullptr ? node->prev->next : _refs.front()) = node->next;
+        (node->next != nullptr ? node->next->prev : _refs.back()) = node->prev;
+    }
+
+    // Links node in front of next, or behind the tail if next is nullptr, keeping head and tail
+    void
+    _link(Node* node, Node* next) noexcept {
+        node->next = next;
+        node->prev = next != nullptr ? next->prev : _refs.back();
+        (node->prev != nullptr ? node->prev->next : _refs.front()) = node;
+        (next != nullptr ? next->prev : _refs.back()) = node;
+    }
+
+    // After _unlink / _link: the anchors between head and tail are stale unless there are none
+    void
+    _stale(void) noexcept {
+        _dirty = _dirty or _refs.size() > 2 or _anchors(_len) > 2;
+        _contiguous = false;
+    }
+
+    template <class U>
+    Node*
+    _insert_before(Node* node, U&& value) {
+        _detach_all();
+        Node* new_node = _new_node(nullptr, std::forward<U>(value), nullptr);
+        _link(new_node, node);
+        ++_len;
+        _stale();
+        return new_node;
+    }
+
+    template <class U>
+    Node*
+    _insert_after(Node* node, U&& value) {
+        if (node == _refs.back()) {
+            return _push_back(std::forward<U>(value));
+        }
+        return _insert_before(node->next, std::forward<U>(value));
+    }
+
+    Node*
+    _move_before(Node* node, Node* next) noexcept {
+        if (node != next and node->next != next) {
+            _detach_all();
+            _unlink(node);
+            _link(node, next);
+            _stale();
+        }
+        return node;
+    }
+
+    // Removes the last anchor, halving the index storage once it is less than a quarter used
+    void
+    _pop_ref(void) noexcept {
+        _refs.pop_back();
+        if (_refs.capacity() >= 64 and _refs.size() * 4 <= _refs.capacity()) {
+            try {
+                std::vector<Node*> refs;
+                refs.reserve(_refs.size() * 2);
+                refs.assign(_refs.begin(), _refs.end());
+                _refs.swap(refs);
+                DOUBLY_LINKED_LIST_COUNT(reallocations, 1);
+            } catch (const std::bad_alloc&) {
+                // Keeping the larger storage is fine
+            }
+        }
+    }
+
+    // Nodes the pool can hold without allocating: in use, on the free list or not carved yet
+    [[nodiscard]] uint64_t
+    _pooled(void) const noexcept {
+        uint64_t pooled = 0;
+        for (const Block& block : _blocks) {
+            pooled += block.capacity;
+        }
+        return pooled;
+    }
+
+    void
+    _push_ref(Node* node) {
+        [[maybe_unused]] size_t capacity = _refs.capacity();
+        _refs.push_back(node);
+        DOUBLY_LINKED_LIST_COUNT(reallocations, _refs.capacity() != capacity ? 1 : 0);
+    }
+
+    /**
+     * Nodes are carved out of blocks; freed nodes go to a free list. Once the list has shrunk to
+     * a quarter of its peak length, _trim releases the blocks all of whose nodes are free, the
+     * rest waits for clear() or shrink_to_fit().
+     */
+    struct Block {
+        Node* nodes;
+        size_t capacity;
+    };
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    // Lists at least this long are built by several threads in _assign
+    static constexpr uint64_t _parallel_threshold = 1 << 16;
+
+    template <class U>
+    Node*
+    _new_node(Node* prev, U&& value, Node* next) {
+        Node* node = nullptr;
+        _contiguous = false;
+        _peak = std::max<uint64_t>(_peak, _len + 1);
+        if (_free != nullptr) {
+            node = reinterpret_cast<Node*>(std::exchange(_free, _free->next));
+        } else {
+            if (_blocks.empty() or _used == _blocks.back().capacity) {
+                _grow(std::clamp<uint64_t>(_len, 8, 1 << 16));
+            }
+            node = _blocks.back().nodes + _used++;
+        }
+        DOUBLY_LINKED_LIST_COUNT(allocations, 1);
+        try {
+            return new (node) Node{prev, std::forward<U>(value), next};
+        } catch (...) {
+            _free = new (node) FreeNode{_free};
+            throw;
+        }
+    }
+
+    void
+    _delete_node(Node* node) noexcept {
+        DOUBLY_LINKED_LIST_COUNT(frees, 1);
+        node->~Node();
+        _free = new (node) FreeNode{_free};
+        _peak = std::max(_peak, _len);
+        if (_len * 4 < _peak) {
+            _trim();
+        }
+    }
+
+    /**
+     * Gives the blocks whose carved nodes are all on the free list back to the allocator, except
+     * the one _new_node carves from. Nodes in the list stay where they are, so every Node* stays
+     * valid. O(free nodes * log(blocks)), and the next call waits until the list has shrunk to a
+     * quarter of its length again, so popping pays O(log(blocks)) amortized.
+     */
+    void
+    _trim(void) noexcept {
+        _peak = _len;
+        size_t count = _blocks.size();
+        if (count < 2) {
+            return;
+        }
+        // Blocks by address and, per block, its nodes on the free list
+        std::vector<std::pair<const Node*, size_t>> starts;
+        std::vector<uint64_t> free;
+        try {
+            starts.reserve(count);
+            free.assign(count, 0);
+        } catch (const std::bad_alloc&) {
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            starts.emplace_back(_blocks[i].nodes, i);
+        }
+        std::sort(starts.begin(), starts.end(),
+                  [](const auto& a, const auto& b) -> bool { return std::less<const Node*>()(a.first, b.first); });
+        auto block = [&starts](const FreeNode* node) -> size_t {
+            auto it = std::upper_bound(starts.begin(), starts.end(), reinterpret_cast<const Node*>(node),
+                                       [](const Node* address, const auto& start) -> bool {
+                                           return std::less<const Node*>()(address, start.first);
+                                       });
+            return std::prev(it)->second;
+        };
+        for (FreeNode* node = _free; node != nullptr; node = node->next) {
+            ++free[block(node)];
+        }
+
+        bool released = false;
+        for (size_t i = 0; i + 1 < count; ++i) {
+            released = released or free[i] == _blocks[i].capacity;
+        }
+        if (not released) {
+            return;
+        }
+        FreeNode** link = &_free;
+        for (FreeNode* node = _free; node != nullptr; node = node->next) {
+            size_t i = block(node);
+            if (i + 1 == count or free[i] != _blocks[i].capacity) {
+                *link = node;
+                link = &node->next;
+            }
+        }
+        *link = nullptr;
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (i + 1 < count and free[i] == _blocks[i].capacity) {
+                std::allocator<Node>().deallocate(_blocks[i].nodes, _blocks[i].capacity);
+            } else {
+                _blocks[kept++] = _blocks[i];
+            }
+        }
+        _blocks.resize(kept);
+    }
+
+    // Appends an empty block of capacity nodes and makes it the one _new_node carves from
+    void
+    _grow(size_t capacity) {
+        _blocks.reserve(_blocks.size() + 1);
+        Node* nodes = std::allocator<Node>().allocate(capacity);
+        // Nodes of the current block that were never handed out stay available
+        if (not _blocks.empty()) {
+            for (Block& block = _blocks.back(); _used < block.capacity; ++_used) {
+                _free = new (block.nodes + _used) FreeNode{_free};
+            }
+        }
+        _blocks.push_back({nodes, capacity});
+        _used = 0;
+        DOUBLY_LINKED_LIST_COUNT(blocks, 1);
+    }
+
+    // Implicit treap of apply_batch, over the list as the ops replayed so far left it
+    class Pieces {
+      public:
+        static constexpr uint64_t nil = ~uint64_t(0);
+
+        struct Piece {
+            // Original positions [begin, end), or the index of an inserted value and end = nil
+            uint64_t begin;
+            uint64_t end;
+            // Values in the subtree
+            uint64_t length;
+            uint64_t priority;
+            uint64_t left = nil;
+            uint64_t right = nil;
+        };
+
+        // Every op adds at most three pieces: two splits and the inserted value
+        Pieces(uint64_t length, uint64_t ops) {
+            _pieces.reserve(1 + 3 * ops);
+            if (length > 0) {
+                _root = _make(0, length);
+            }
+        }
+
+        [[nodiscard]] uint64_t
+        length(void) const noexcept {
+            return _length(_root);
+        }
+
+        void
+        insert(uint64_t pos, uint64_t value) {
+            auto [left, right] = _split(_root, pos);
+            _root = _merge(_merge(left, _make(value, nil)), right);
+        }
+
+        // The piece of the single value taken out at pos
+        const Piece&
+        pop(uint64_t pos) {
+            auto [left, rest] = _split(_root, pos);
+            auto [piece, right] = _split(rest, 1);
+            _root = _merge(left, right);
+            return _pieces[piece];
+        }
+
+        // Pieces from head to tail
+        [[nodiscard]] std::vector<uint64_t>
+        order(void) const {
+            std::vector<uint64_t> order, stack;
+            order.reserve(_pieces.size());
+            for (uint64_t piece = _root; piece != nil or not stack.empty();) {
+                if (piece != nil) {
+                    stack.push_back(piece);
+                    piece = _pieces[piece].left;
+                } else {
+                    piece = stack.back();
+                    stack.pop_back();
+                    order.push_back(piece);
+                    piece = _pieces[piece].right;
+                }
+            }
+            return order;
+        }
+
+        const Piece&
+        operator[](uint64_t piece) const noexcept {
+            return _pieces[piece];
+        }
+
+      private:
+        uint64_t
+        _make(uint64_t begin, uint64_t end) {
+            // xorshift64
+            _seed ^= _seed << 13;
+            _seed ^= _seed >> 7;
+            _seed ^= _seed << 17;
+            _pieces.push_back({begin, end, end == nil ? 1 : end - begin, _seed});
+            return _pieces.size() - 1;
+        }
+
+        [[nodiscard]] uint64_t
+        _length(uint64_t piece) const noexcept {
+            return piece == nil ? 0 : _pieces[piece].length;
+        }
+
+        // Values of the piece itself
+        [[nodiscard]] uint64_t
+        _own(uint64_t piece) const noexcept {
+            const Piece& p = _pieces[piece];
+            return p.end == nil ? 1 : p.end - p.begin;
+        }
+
+        void
+        _update(uint64_t piece) noexcept {
+            Piece& p = _pieces[piece];
+            p.length = _own(piece) + _length(p.left) + _length(p.right);
+        }
+
+        uint64_t
+        _merge(uint64_t left, uint64_t right) noexcept {
+            if (left == nil or right == nil) {
+                return left == nil ? right : left;
+            }
+            if (_pieces[left].priority > _pieces[right].priority) {
+                _pieces[left].right = _merge(_pieces[left].right, right);
+                _update(left);
+                return left;
+            }
+            _pieces[right].left = _merge(left, _pieces[right].left);
+            _update(right);
+            return right;
+        }
+
+        // (first pos values, the rest), cutting a run in two if pos falls inside it
+        std::pair<uint64_t, uint64_t>
+        _split(uint64_t piece, uint64_t pos) {
+            if (piece == nil) {
+                return {nil, nil};
+            }
+            uint64_t before = _length(_pieces[piece].left), own = _own(piece);
+            if (pos <= before) {
+                auto [left, right] = _split(_pieces[piece].left, pos);
+                _pieces[piece].left = right;
+                _update(piece);
+                return {left, piece};
+            }
+            if (pos >= before + own) {
+                auto [left, right] = _split(_pieces[piece].right, pos - before - own);
+                _pieces[piece].right = left;
+                _update(piece);
+                return {piece, right};
+            }
+            // The run is cut in two, the second half goes with the right subtree
+            uint64_t cut = _pieces[piece].begin + pos - before, right = _pieces[piece].right;
+            uint64_t second = _make(cut, _pieces[piece].end);
+            _pieces[piece].end = cut;
+            _pieces[piece].right = nil;
+            _update(piece);
+            return {piece, _merge(second, right)};
+        }
+
+        std::vector<Piece> _pieces;
+        uint64_t _root = nil;
+        uint64_t _seed = 0x9e3779b97f4a7c15;
+    };
+
+    // Appends count > 0 linked nodes behind the tail, a block of their own they use up
+    void
+    _splice(Node* nodes, uint64_t count) {
+        _blocks.reserve(_blocks.size() + 1);
+        _refs.reserve(_anchors(_len + count));
+        // Only the first can copy out a segment and so throw, nothing has changed by then
+        for (uint64_t i = 0; i < count; ++i) {
+            _snapshot_insert(_len + i);
+        }
+        if (_blocks.empty()) {
+            _blocks.push_back({nodes, count});
+            _used = count;
+        } else {
+            _blocks.insert(_blocks.end() - 1, {nodes, count});
+        }
+        DOUBLY_LINKED_LIST_COUNT(blocks, 1);
+        DOUBLY_LINKED_LIST_COUNT(allocations, count);
+
+        Node* tail = _refs.back();
+        if (tail != nullptr) {
+            tail->next = nodes;
+            nodes->prev = tail;
+        }
+        // Anchors of positions <= length - 2, the tail is the last entry
+        uint64_t anchors = _len == 0 ? 0 : _refs.size() - 1;
+        _refs.resize(anchors);
+        for (uint64_t k = anchors; k + 1 < _anchors(_len + count); ++k) {
+            uint64_t pos = k * _size;
+            _push_ref(pos < _len ? tail : nodes + (pos - _len));
+        }
+        _push_ref(nodes + count - 1);
+        // The fingerprints of the full segments before still hold
+        _hashes.resize(std::min<uint64_t>(_hashes.size(), _len / _size));
+        _len += count;
+        _contiguous = false;
+    }
+
+    /**
+     * Pipeline of ingest: read(buffer, size) returns the bytes it put into buffer, 0 at the end.
+     * Chunks of whole lines carry their sequence number; parsed chains wait in ready until all
+     * those before them are spliced. At most two chunks per parser are read but not spliced.
+     */
+    template <class Read>
+    std::future<uint64_t>
+    _ingest(Read read, unsigned parsers) {
+        assert(from_string != nullptr
+               and "Please provide like so: list.from_string = [](std::string line) -> T {...}");
+        if (parsers == 0) {
+            parsers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        }
+        return std::async(std::launch::async, [this, read, parsers]() -> uint64_t {
+            if (_reversed) {
+                _detach_all();
+                _normalize();
+            }
+            _repair();
+
+            struct Chain {
+                Node* nodes;
+                uint64_t count;
+            };
+            std::mutex mutex;
+            std::condition_variable changed;
+            std::deque<std::pair<uint64_t, std::string>> chunks;
+            std::map<uint64_t, Chain> ready;
+            uint64_t read_chunks = 0, spliced = 0, appended = 0;
+            bool done = false;
+            std::exception_ptr error;
+
+            auto fail = [&](std::exception_ptr exception) -> void {
+                std::lock_guard lock(mutex);
+                error = error ? error : exception;
+                changed.notify_all();
+            };
+            auto reader = [&]() -> void {
+                std::vector<char> buffer(ingest_block);
+                std::string carry;
+                for (bool end = false; not end;) {
+                    size_t n = read(buffer.data(), buffer.size());
+                    end = n == 0;
+                    std::string text = std::move(carry);
+                    text.append(buffer.data(), n);
+                    size_t cut = end ? text.size() : text.rfind('\n') + 1;
+                    if (end and not text.empty() and text.back() != '\n') {
+                        text.push_back('\n');
+                        ++cut;
+                    }
+                    carry = text.substr(cut);
+                    text.resize(cut);
+                    if (text.empty()) {
+                        continue;
+                    }
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [&]() -> bool { return error or read_chunks - spliced < 2 * parsers; });
+                    if (error) {
+                        return;
+                    }
+                    chunks.emplace_back(read_chunks++, std::move(text));
+                    changed.notify_all();
+                }
+                std::lock_guard lock(mutex);
+                done = true;
+                changed.notify_all();
+            };
+            auto parse = [this](const std::string& text) -> Chain {
+                uint64_t count = std::count(text.begin(), text.end(), '\n');
+                Node* nodes = std::allocator<Node>().allocate(count);
+                uint64_t i = 0;
+                try {
+                    std::string line;
+                    for (size_t start = 0; i < count; ++i) {
+                        size_t end = text.find('\n', start);
+                        line.assign(text, start, end - start);
+                        new (nodes + i) Node{i == 0 ? nullptr : nodes + i - 1, from_string(line),
+                                             i + 1 == count ? nullptr : nodes + i + 1};
+                        start = end + 1;
+                    }
+                } catch (...) {
+                    while (i > 0) {
+                        nodes[--i].~Node();
+                    }
+                    std::allocator<Node>().deallocate(nodes, count);
+                    throw;
+                }
+                return {nodes, count};
+            };
+            auto parser = [&]() -> void {
+                std::unique_lock lock(mutex);
+                while (true) {
+                    changed.wait(lock, [&]() -> bool { return error or done or not chunks.empty(); });
+                    if (error or chunks.empty()) {
+                        return;
+                    }
+                    auto [seq, text] = std::move(chunks.front());
+                    chunks.pop_front();
+                    lock.unlock();
+                    Chain chain = parse(text);
+                    lock.lock();
+                    ready.emplace(seq, chain);
+                    for (auto it = ready.begin(); it != ready.end() and it->first == spliced; it = ready.erase(it)) {
+                        if (it->second.count > 0) {
+                            _splice(it->second.nodes, it->second.count);
+                            appended += it->second.count;
+                        }
+                        ++spliced;
+                    }
+                    changed.notify_all();
+                }
+            };
+
+            _spawn(parsers + 1, [&](unsigned chunk) -> void {
+                try {
+                    chunk == 0 ? reader() : parser();
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+            });
+            for (auto& [seq, chain] : ready) {
+                for (uint64_t i = 0; i < chain.count; ++i) {
+                    chain.nodes[i].~Node();
+                }
+                std::allocator<Node>().deallocate(chain.nodes, chain.count);
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return appended;
+        });
+    }
+
+    // Moves count nodes starting at the size-aligned position pos into a new block with room for spare more
+    void
+    _relocate(uint64_t pos, uint64_t count, uint64_t spare = 0) {
+        _blocks.reserve(_blocks.size() + 1);
+        Node* nodes = std::allocator<Node>().allocate(count + spare);
+        DOUBLY_LINKED_LIST_COUNT(blocks, 1);
+        DOUBLY_LINKED_LIST_COUNT(allocations, count);
+        Node* first = _segment(pos / _size);
+        Node* node = first;
+        uint64_t i = 0;
+        try {
+            for (; i < count; ++i, node = node->next) {
+                new (nodes + i) Node{i == 0 ? first->prev : nodes + i - 1, std::move_if_noexcept(node->value), nullptr};
+                if (i > 0) {
+                    nodes[i - 1].next = nodes + i;
+                }
+            }
+        } catch (...) {
+            while (i > 0) {
+                nodes[--i].~Node();
+            }
+            std::allocator<Node>().deallocate(nodes, count + spare);
+            throw;
+        }
+
+        nodes[count - 1].next = node;
+        if (first->prev != nullptr) {
+            first->prev->next = nodes;
+        }
+        if (node != nullptr) {
+            node->prev = nodes + count - 1;
+        }
+        for (uint64_t j = pos / _size; j < _refs.size() - 1 and j * _size < pos + count; ++j) {
+            _refs[j] = nodes + (j * _size - pos);
+        }
+        if (pos + count == _len) {
+            _refs.back() = nodes + count - 1;
+        }
+
+        for (node = first, i = 0; i < count; ++i) {
+            Node* next = node->next;
+            _delete_node(node);
+            node = next;
+        }
+        // The new block is full, keep carving from the current one; compact() carves the spare nodes from it
+        if (_blocks.empty()) {
+            _blocks.push_back({nodes, count + spare});
+            _used = count;
+        } else {
+            _blocks.insert(_blocks.end() - 1, {nodes, count + spare});
+        }
+    }
+
+    /**
+     * Builds an empty list from n values of a random access range: all nodes come from one
+     * block, so node i is simply block + i and _refs can be filled in without walking. Lists of
+     * at least _parallel_threshold values are split into runs of whole segments that are
+     * constructed and linked by separate threads.
+     */
+    template <class RandomIt>
+    void
+    _assign(RandomIt first, uint64_t n) {
+        if (n == 0) {
+            return;
+        }
+        _grow(n);
+        _used = n;
+        DOUBLY_LINKED_LIST_COUNT(allocations, n);
+        Node* nodes = _blocks.back().nodes;
+        _len = n;
+        _refs.assign(n == 1 ? 2 : 2 + (n - 2) / _size, nullptr);
+        _refs.back() = nodes + n - 1;
+
+        auto build = [this, first, n, nodes](uint64_t begin, uint64_t end) -> void {
+            for (uint64_t i = begin; i < end; ++i) {
+                new (nodes + i) Node{i == 0 ? nullptr : nodes + i - 1, first[i], i + 1 == n ? nullptr : nodes + i + 1};
+                if (i % _size == 0 and i / _size < _refs.size() - 1) {
+                    _refs[i / _size] = nodes + i;
+                }
+            }
+        };
+        if constexpr (std::is_nothrow_copy_constructible_v<T>) {
+            unsigned threads = n < _parallel_threshold ? 1 : _threads(par);
+            uint64_t segments = _segments();
+            _run(threads, [this, &build, threads, segments, n](unsigned chunk) -> void {
+                build(std::min<uint64_t>(segments * chunk / threads * _size, n),
+                      std::min<uint64_t>(segments * (chunk + 1) / threads * _size, n));
+            });
+        } else {
+            uint64_t i = 0;
+            try {
+                for (; i < n; ++i) {
+                    build(i, i + 1);
+                }
+            } catch (...) {
+                while (i > 0) {
+                    nodes[--i].~Node();
+                }
+                std::allocator<Node>().deallocate(nodes, n);
+                _blocks.pop_back();
+                _used = 0;
+                _len = 0;
+                _refs = {nullptr, nullptr};
+                throw;
+            }
+        }
+        _contiguous = true;
+    }
+
+    [[nodiscard]] uint64_t
+    _segments(void) const noexcept {
+        return _len == 0 ? 0 : (_len - 1) / _size + 1;
+    }
+
+    // First node of the i-th size-long segment
+    [[nodiscard]] Node*
+    _segment(uint64_t i) const noexcept {
+        return i < _refs.size() - 1 ? _refs[i] : _refs.back();
+    }
+
+    // Values of the i-th segment from the head, which is segment _segments() - 1 - i in storage order after reverse()
+    [[nodiscard]] Slice
+    _slice(uint64_t i) const noexcept {
+        uint64_t segments = _segments(), k = _reversed ? segments - 1 - i : i;
+        Node *first = _segment(k), *next = k + 1 < segments ? _segment(k + 1) : nullptr;
+        uint64_t count = std::min<uint64_t>(_size, _len - k * _size);
+        if (_reversed) {
+            Node* last = next == nullptr ? _refs.back() : next->prev;
+            return Slice(Iterator(last, true), Iterator(first->prev, true), count);
+        }
+        return Slice(Iterator(first), Iterator(next), count);
+    }
+
+    [[nodiscard]] unsigned
+    _threads(const Sequenced&) const noexcept {
+        return _len == 0 ? 0 : 1;
+    }
+
+    [[nodiscard]] unsigned
+    _threads(const Parallel& policy) const noexcept {
+        unsigned threads = policy.threads ? policy.threads : std::thread::hardware_concurrency();
+        return static_cast<unsigned>(std::min<uint64_t>(std::max(threads, 1u), _segments()));
+    }
+
+    /**
+     * Calls f(chunk, first segment, its node, node count) for _threads(policy) disjoint runs of
+     * whole segments
+     */
+    template <class Policy, class F>
+    void
+    _for_chunks(const Policy& policy, F&& f) const {
+        _repair();
+        unsigned threads = _threads(policy);
+        uint64_t segments = _segments();
+        _run(threads, [this, threads, segments, &f](unsigned chunk) -> void {
+            uint64_t first = segments * chunk / threads, last = segments * (chunk + 1) / threads;
+            f(chunk, first, _segment(first), std::min<uint64_t>(last * _size, _len) - first * _size);
+        });
+    }
+
+    // Calls f(node) for count nodes starting at node, the head of the given segment
+    template <class F>
+    void
+    _walk(uint64_t segment, Node* node, uint64_t count, F&& f) const {
+        for (uint64_t segments = _segments(); count > 0; ++segment) {
+            if (segment + 1 < segments) {
+                _prefetch(_segment(segment + 1));
+            }
+            for (uint64_t i = std::min<uint64_t>(count, _size); i > 0; --i, --count) {
+                Node* next = node->next;
+                _prefetch_hop(next);
+                f(node);
+                node = next;
+            }
+        }
+    }
+
+    static void
+    _prefetch([[maybe_unused]] const void* address) noexcept {
+#ifdef DOUBLY_LINKED_LIST_PREFETCH
+        __builtin_prefetch(address);
+#endif
+    }
+
+    // Values each kernel below handles side by side: every lane accumulates on its own, so the loops vectorize
+    static constexpr unsigned _lanes = 8;
+
+#ifdef DOUBLY_LINKED_LIST_AVX2
+    [[nodiscard]] static bool
+    _has_avx2(void) noexcept {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+#endif
+
+    // Calls kernel, an always_inline lambda running one of the kernels, built for AVX2 if the CPU has it
+    template <class Kernel>
+    static auto
+    _vectorized(const Kernel& kernel) {
+#ifdef DOUBLY_LINKED_LIST_AVX2
+        if (_has_avx2()) {
+            return _avx2(kernel);
+        }
+#endif
+        return kernel();
+    }
+
+#ifdef DOUBLY_LINKED_LIST_AVX2
+    template <class Kernel>
+    __attribute__((target("avx2"))) static auto
+    _avx2(const Kernel& kernel) {
+        return kernel();
+    }
+#endif
+
+    // Folds the values of n > 0 contiguous nodes into _lanes results with step, then those with merge
+    template <class U, class Step, class Merge>
+    [[gnu::always_inline]] static inline U
+    _fold(const Node* nodes, uint64_t n, const U& init, const Step& step, const Merge& merge) {
+        U lanes[_lanes];
+        std::fill(lanes, lanes + _lanes, init);
+        uint64_t i = 0;
+        for (; i + _lanes <= n; i += _lanes) {
+            for (unsigned j = 0; j < _lanes; ++j) {
+                lanes[j] = step(lanes[j], nodes[i + j].value);
+            }
+        }
+        for (; i < n; ++i) {
+            lanes[0] = step(lanes[0], nodes[i].value);
+        }
+        for (unsigned j = 1; j < _lanes; ++j) {
+            lanes[0] = merge(lanes[0], lanes[j]);
+        }
+        return lanes[0];
+    }
+
+    // Position of the first (last if backward) of n contiguous nodes holding value, n if none does
+    [[gnu::always_inline]] static inline uint64_t
+    _find(const Node* nodes, uint64_t n, const T& value, bool backward) {
+        // Nodes checked for a match at once, before looking for the first one among them
+        constexpr uint64_t window = 4 * _lanes;
+        auto match = [&value](bool found, const T& other) -> bool { return found | (other == value); };
+        for (uint64_t i = 0; i < n; i += window) {
+            uint64_t count = std::min(window, n - i), first = backward ? n - i - count : i;
+            if (_fold(nodes + first, count, false, match, std::logical_or<bool>())) {
+                for (uint64_t j = 0; j < count; ++j) {
+                    uint64_t pos = backward ? first + count - 1 - j : first + j;
+                    if (nodes[pos].value == value) {
+                        return pos;
+                    }
+                }
+            }
+        }
+        return n;
+    }
+
+    // find(): _find, or _find_avx2 if there is one for T and the CPU runs it
+    [[nodiscard]] static uint64_t
+    _search(const Node* nodes, uint64_t n, const T& value, bool backward) {
+#ifdef DOUBLY_LINKED_LIST_AVX2
+        if constexpr (_lane_kernels()) {
+            if (_has_avx2()) {
+                return _find_avx2(nodes, n, value, backward);
+            }
+        }
+#endif
+        return _vectorized([nodes, n, &value, backward]() __attribute__((always_inline)) -> uint64_t {
+            return _find(nodes, n, value, backward);
+        });
+    }
+
+    // count(): values of n contiguous nodes equal to value
+    [[nodiscard]] static uint64_t
+    _count(const Node* nodes, uint64_t n, const T& value) {
+#ifdef DOUBLY_LINKED_LIST_AVX2
+        if constexpr (_lane_kernels()) {
+            if (_has_avx2()) {
+                return _count_avx2(nodes, n, value);
+            }
+        }
+#endif
+        return _vectorized([nodes, n, &value]() __attribute__((always_inline)) -> uint64_t {
+            return _fold(
+                nodes, n, uint64_t(0),
+                [&value](uint64_t count, const T& other) -> uint64_t { return count + (other == value); },
+                std::plus<uint64_t>());
+        });
+    }
+
+    /**
+     * Whether T has the AVX2 kernels below. Values are strided by sizeof(Node), too far apart to
+     * load them side by side, so the kernels compare the whole node array as lanes of sizeof(T)
+     * bytes and keep the lanes that hold a value: 32 nodes span sizeof(Node) vectors, in which
+     * those lanes sit at the same bytes every time.
+     */
+    [[nodiscard]] static constexpr bool
+    _lane_kernels(void) noexcept {
+        if constexpr ((std::is_integral_v<T> and sizeof(T) <= 8) or std::is_same_v<T, float>
+                      or std::is_same_v<T, double>) {
+            return sizeof(Node) % sizeof(T) == 0 and offsetof(Node, value) % sizeof(T) == 0;
+        }
+        return false;
+    }
+
+#ifdef DOUBLY_LINKED_LIST_AVX2
+    // Vectors of 32 bytes after which the lanes holding values repeat: lcm(32, sizeof(Node)) / 32
+    static constexpr unsigned _period = sizeof(Node) / std::min<size_t>(32, sizeof(Node) & (0 - sizeof(Node)));
+
+    // _period vectors, all ones where a byte of contiguous nodes is the first byte of a value
+    [[nodiscard]] static const uint8_t*
+    _value_bytes(void) noexcept {
+        struct Bytes {
+            alignas(32) uint8_t bytes[32 * _period] = {};
+
+            Bytes(void) {
+                for (uint64_t byte = offsetof(Node, value); byte < 32 * _period; byte += sizeof(Node)) {
+                    bytes[byte] = 0xff;
+                }
+            }
+        };
+        static const Bytes bytes;
+        return bytes.bytes;
+    }
+
+    // value in every lane of sizeof(T) bytes
+    __attribute__((target("avx2"))) static __m256i
+    _broadcast(const T& value) noexcept {
+        if constexpr (std::is_same_v<T, float>) {
+            return _mm256_castps_si256(_mm256_set1_ps(value));
+        } else if constexpr (std::is_same_v<T, double>) {
+            return _mm256_castpd_si256(_mm256_set1_pd(value));
+        } else if constexpr (sizeof(T) == 1) {
+            return _mm256_set1_epi8(static_cast<char>(value));
+        } else if constexpr (sizeof(T) == 2) {
+            return _mm256_set1_epi16(static_cast<int16_t>(value));
+        } else if constexpr (sizeof(T) == 4) {
+            return _mm256_set1_epi32(static_cast<int32_t>(value));
+        } else {
+            return _mm256_set1_epi64x(static_cast<int64_t>(value));
+        }
+    }
+
+    // The 32 bytes at bytes compared with target as lanes of T (so 0.0 == -0.0), all ones in lanes that match
+    __attribute__((target("avx2"))) static __m256i
+    _compare(const char* bytes, __m256i target) noexcept {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes));
+        if constexpr (std::is_same_v<T, float>) {
+            return _mm256_castps_si256(
+                _mm256_cmp_ps(_mm256_castsi256_ps(lanes), _mm256_castsi256_ps(target), _CMP_EQ_OQ));
+        } else if constexpr (std::is_same_v<T, double>) {
+            return _mm256_castpd_si256(
+                _mm256_cmp_pd(_mm256_castsi256_pd(lanes), _mm256_castsi256_pd(target), _CMP_EQ_OQ));
+        } else if constexpr (sizeof(T) == 1) {
+            return _mm256_cmpeq_epi8(lanes, target);
+        } else if constexpr (sizeof(T) == 2) {
+            return _mm256_cmpeq_epi16(lanes, target);
+        } else if constexpr (sizeof(T) == 4) {
+            return _mm256_cmpeq_epi32(lanes, target);
+        } else {
+            return _mm256_cmpeq_epi64(lanes, target);
+        }
+    }
+
+    /**
+     * _find over 32 nodes, sizeof(Node) vectors, at a time: the comparisons are OR-ed into one
+     * accumulator per phase of _period vectors, masked by _value_bytes once and tested once.
+     * The nodes past the last 32 are left to _find.
+     */
+    __attribute__((target("avx2"))) static uint64_t
+    _find_avx2(const Node* nodes, uint64_t n, const T& value, bool backward) {
+        __m256i target = _broadcast(value), masks[_period];
+        for (unsigned j = 0; j < _period; ++j) {
+            masks[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(_value_bytes() + 32 * j));
+        }
+        uint64_t blocks = n / 32, rest = n % 32, pos = _find(nodes + blocks * 32, rest, value, backward);
+        if (backward and pos < rest) {
+            return blocks * 32 + pos;
+        }
+        for (uint64_t i = 0; i < blocks; ++i) {
+            uint64_t block = backward ? blocks - 1 - i : i;
+            const char* bytes = reinterpret_cast<const char*>(nodes + block * 32);
+            __m256i any[_period], found = _mm256_setzero_si256();
+            for (unsigned j = 0; j < _period; ++j) {
+                any[j] = _mm256_setzero_si256();
+            }
+            for (unsigned k = 0; k < sizeof(Node); k += _period) {
+                for (unsigned j = 0; j < _period; ++j) {
+                    any[j] = _mm256_or_si256(any[j], _compare(bytes + 32 * (k + j), target));
+                }
+            }
+            for (unsigned j = 0; j < _period; ++j) {
+                found = _mm256_or_si256(found, _mm256_and_si256(any[j], masks[j]));
+            }
+            if (_mm256_testz_si256(found, found)) {
+                continue;
+            }
+            for (unsigned m = 0; m < sizeof(Node); ++m) {
+                unsigned k = backward ? sizeof(Node) - 1 - m : m;
+                __m256i matches = _mm256_and_si256(_compare(bytes + 32 * k, target), masks[k % _period]);
+                uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(matches));
+                if (bits != 0) {
+                    uint64_t byte = 32 * k + (backward ? 31 - __builtin_clz(bits) : __builtin_ctz(bits));
+                    return block * 32 + byte / sizeof(Node);
+                }
+            }
+        }
+        return pos < rest ? blocks * 32 + pos : n;
+    }
+
+    /**
+     * count() over 32 nodes at a time: every matching lane takes one off the byte counters of its
+     * phase (all ones is -1), which stay below 256 for 32 nodes; the counters of the first bytes of
+     * values are kept by _value_bytes and summed up by _mm256_sad_epu8
+     */
+    __attribute__((target("avx2"))) static uint64_t
+    _count_avx2(const Node* nodes, uint64_t n, const T& value) {
+        __m256i target = _broadcast(value), zero = _mm256_setzero_si256(), sums = zero, masks[_period];
+        for (unsigned j = 0; j < _period; ++j) {
+            masks[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(_value_bytes() + 32 * j));
+        }
+        uint64_t blocks = n / 32;
+        for (uint64_t block = 0; block < blocks; ++block) {
+            const char* bytes = reinterpret_cast<const char*>(nodes + block * 32);
+            __m256i counts[_period];
+            for (unsigned j = 0; j < _period; ++j) {
+                counts[j] = zero;
+            }
+            for (unsigned k = 0; k < sizeof(Node); k += _period) {
+                for (unsigned j = 0; j < _period; ++j) {
+                    counts[j] = _mm256_sub_epi8(counts[j], _compare(bytes + 32 * (k + j), target));
+                }
+            }
+            for (unsigned j = 0; j < _period; ++j) {
+                sums = _mm256_add_epi64(sums, _mm256_sad_epu8(_mm256_and_si256(counts[j], masks[j]), zero));
+            }
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+        uint64_t count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        for (uint64_t i = blocks * 32; i < n; ++i) {
+            count += nodes[i].value == value;
+        }
+        return count;
+    }
+#endif
+
+    // Whether n contiguous nodes hold the same values as n others, compared a window at a time
+    [[gnu::always_inline]] static inline bool
+    _equal(const Node* nodes, const Node* others, uint64_t n) {
+        constexpr uint64_t window = 4 * _lanes;
+        uint64_t i = 0;
+        for (; i + window <= n; i += window) {
+            bool same = true;
+            for (unsigned j = 0; j < window; ++j) {
+                same &= nodes[i + j].value == others[i + j].value;
+            }
+            if (not same) {
+                return false;
+            }
+        }
+        for (; i < n; ++i) {
+            if (not(nodes[i].value == others[i].value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // min() / max(): pick(a, b) returns the one to keep
+    template <class Pick>
+    [[nodiscard]] T
+    _extreme(const Pick& pick) const {
+        static_assert(std::is_arithmetic_v<T>, "min() and max() need an arithmetic T");
+        if (_len == 0) {
+            return T();
+        }
+        const Node* nodes = _refs.front();
+        if (_contiguous) {
+            return _vectorized([this, nodes, &pick]() __attribute__((always_inline)) -> T {
+                return _fold(nodes, _len, nodes->value, pick, pick);
+            });
+        }
+        return reduce(seq, nodes->value, pick);
+    }
+
+    // Address of the node distance hops away if nodes from node on are laid out contiguously
+    [[nodiscard]] static const void*
+    _ahead(const Node* node, std::ptrdiff_t distance) noexcept {
+        // Never dereferenced, only handed to _prefetch
+        return reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(node) + distance * sizeof(Node));
+    }
+
+    // Called when a traversal arrives at node (moving forward by default)
+    static void
+    _prefetch_hop([[maybe_unused]] const Node* node, [[maybe_unused]] bool backward = false) noexcept {
+#ifdef DOUBLY_LINKED_LIST_PREFETCH
+        if (node != nullptr) {
+            _prefetch(backward ? node->prev : node->next);
+            std::ptrdiff_t distance = DOUBLY_LINKED_LIST_PREFETCH_DISTANCE;
+            _prefetch(_ahead(node, backward ? -distance : distance));
+        }
+#endif
+    }
+
+    // Shared by a Snapshot and the list it was taken from, see snapshot()
+    struct SnapshotState {
+        // Node at position i * size in storage order when the snapshot was taken
+        std::vector<Node*> anchors;
+        uint64_t len;
+        S size;
+        bool reversed;
+        // Live nodes in storage order in front of those that took the place of the segments
+        uint64_t before = 0;
+        // Fenwick tree over the number of live nodes that took the place of each segment
+        std::vector<int64_t> spans;
+        // Values of the segments copied out before the list changed them, empty while shared
+        std::vector<std::vector<T>> detached;
+        // Segments still shared, the list forgets the snapshot at 0
+        uint64_t shared;
+        // Taken exclusively by the list to publish a copied out segment
+        mutable std::shared_mutex mutex;
+
+        // Values in segment
+        [[nodiscard]] uint64_t
+        count(uint64_t segment) const noexcept {
+            return segment + 1 < anchors.size() ? size : len - segment * size;
+        }
+
+        // values = the values of segment, read from the list's nodes while it is still shared
+        void
+        copy(uint64_t segment, std::vector<T>& values) const {
+            std::shared_lock lock(mutex);
+            if (not detached[segment].empty()) {
+                values = detached[segment];
+                return;
+            }
+            uint64_t n = count(segment);
+            values.clear();
+            values.reserve(n);
+            // The next link of the last node may already point elsewhere
+            for (Node* node = anchors[segment];; node = node->next) {
+                values.push_back(node->value);
+                if (values.size() == n) {
+                    break;
+                }
+            }
+        }
+
+        // Live nodes that took the place of the first n segments
+        [[nodiscard]] int64_t
+        prefix(uint64_t n) const noexcept {
+            int64_t sum = 0;
+            for (; n > 0; n &= n - 1) {
+                sum += spans[n];
+            }
+            return sum;
+        }
+
+        void
+        add(uint64_t segment, int64_t delta) noexcept {
+            for (uint64_t i = segment + 1; i < spans.size(); i += i & (~i + 1)) {
+                spans[i] += delta;
+            }
+        }
+
+        // Segment holding the live node offset nodes after before, anchors.size() if none does
+        [[nodiscard]] uint64_t
+        find(uint64_t offset) const noexcept {
+            uint64_t segment = 0, step = 1;
+            while (step * 2 < spans.size()) {
+                step *= 2;
+            }
+            int64_t rest = static_cast<int64_t>(offset);
+            for (; step > 0; step /= 2) {
+                if (segment + step < spans.size() and spans[segment + step] <= rest) {
+                    segment += step;
+                    rest -= spans[segment];
+                }
+            }
+            return segment;
+        }
+    };
+
+    // Calls f(state) for every snapshot still sharing segments, forgetting the others
+    template <class F>
+    void
+    _for_snapshots(F&& f) {
+        for (size_t i = 0; i < _snapshots.size();) {
+            std::shared_ptr<SnapshotState> state = _snapshots[i].lock();
+            if (state == nullptr or state->shared == 0) {
+                _snapshots[i] = std::move(_snapshots.back());
+                _snapshots.pop_back();
+            } else {
+                f(*state);
+                ++i;
+            }
+        }
+    }
+
+    // Copies segment out to the snapshot before the list changes it
+    void
+    _detach(SnapshotState& state, uint64_t segment) {
+        if (not state.detached[segment].empty()) {
+            return;
+        }
+        std::vector<T> values;
+        state.copy(segment, values);
+        {
+            std::unique_lock lock(state.mutex);
+            state.detached[segment] = std::move(values);
+        }
+        --state.shared;
+        DOUBLY_LINKED_LIST_COUNT(detached, 1);
+    }
+
+    // Also drops the fingerprints, which are recomputed by their next use
+    void
+    _detach_all(void) {
+        _hashes.clear();
+        _for_snapshots([this](SnapshotState& state) -> void {
+            for (uint64_t segment = 0; segment < state.anchors.size(); ++segment) {
+                _detach(state, segment);
+            }
+        });
+        _snapshots.clear();
+    }
+
+    /**
+     * Called before a node is linked in at storage position pos. The first pass copies segments
+     * out, which may throw, the second one shifts positions once nothing can fail any more, so
+     * no snapshot is left shifted for an insert that did not happen.
+     */
+    void
+    _snapshot_insert(uint64_t pos) {
+        for (bool shift : {false, true}) {
+            _for_snapshots([this, pos, shift](SnapshotState& state) -> void {
+                if (pos <= state.before) {
+                    state.before += shift ? 1 : 0;
+                    return;
+                }
+                // The node in front of it gets a new next link, which matters unless it ends its segment;
+                // a node linked in between two segments counts towards the second one
+                uint64_t offset = pos - 1 - state.before;
+                uint64_t segment = state.find(offset);
+                if (segment == state.anchors.size()) {
+                    return;
+                }
+                if (static_cast<int64_t>(offset + 1) < state.prefix(segment + 1)) {
+                    if (not shift) {
+                        _detach(state, segment);
+                    }
+                } else if (++segment == state.anchors.size()) {
+                    return;
+                }
+                if (shift) {
+                    state.add(segment, 1);
+                }
+            });
+        }
+    }
+
+    // Called before the node at storage position pos is unlinked, in two passes like _snapshot_insert
+    void
+    _snapshot_erase(uint64_t pos) {
+        for (bool shift : {false, true}) {
+            _for_snapshots([this, pos, shift](SnapshotState& state) -> void {
+                if (pos < state.before) {
+                    state.before -= shift ? 1 : 0;
+                    return;
+                }
+                uint64_t segment = state.find(pos - state.before);
+                if (segment == state.anchors.size()) {
+                    return;
+                }
+                if (shift) {
+                    state.add(segment, -1);
+                } else {
+                    _detach(state, segment);
+                }
+            });
+        }
+    }
+
+    // Fingerprints can only be turned on for values std::hash supports
+    static constexpr bool _hashable = std::is_default_constructible_v<std::hash<T>>;
+
+    // Arithmetic modulo the Mersenne prime _prime of the fingerprints
+    static constexpr uint64_t _prime = (uint64_t(1) << 61) - 1;
+    static constexpr uint64_t _base = 0x1c8e4b3f9d27a65 % _prime;
+
+    [[nodiscard]] static constexpr uint64_t
+    _mul(uint64_t a, uint64_t b) noexcept {
+        __uint128_t product = static_cast<__uint128_t>(a) * b;
+        uint64_t result = static_cast<uint64_t>(product & _prime) + static_cast<uint64_t>(product >> 61);
+        return result >= _prime ? result - _prime : result;
+    }
+
+    [[nodiscard]] static constexpr uint64_t
+    _add(uint64_t a, uint64_t b) noexcept {
+        return a + b >= _prime ? a + b - _prime : a + b;
+    }
+
+    [[nodiscard]] static constexpr uint64_t
+    _sub(uint64_t a, uint64_t b) noexcept {
+        return a >= b ? a - b : a + _prime - b;
+    }
+
+    // 1 / _base, by Fermat: _base^(_prime - 2)
+    [[nodiscard]] static constexpr uint64_t
+    _inverse(void) noexcept {
+        uint64_t result = 1, power = _base;
+        for (uint64_t e = _prime - 2; e > 0; e >>= 1, power = _mul(power, power)) {
+            result = e & 1 ? _mul(result, power) : result;
+        }
+        return result;
+    }
+
+    // std::hash of a value modulo _prime; the powers of _base do the mixing
+    [[nodiscard]] static uint64_t
+    _digest([[maybe_unused]] const T& value) noexcept {
+        if constexpr (_hashable) {
+            uint64_t hash = static_cast<uint64_t>(std::hash<T>{}(value));
+            hash = (hash & _prime) + (hash >> 61);
+            return hash >= _prime ? hash - _prime : hash;
+        } else {
+            return 0;
+        }
+    }
+
+    // Fingerprint of count values from node: sum of digest(value k) * _base^k
+    [[nodiscard]] uint64_t
+    _hash_segment(const Node* node, uint64_t count) const noexcept {
+        uint64_t hash = 0;
+        for (uint64_t k = 0; k < count; ++k, node = node->next) {
+            hash = _add(hash, _mul(_digest(node->value), _powers[k]));
+        }
+        return hash;
+    }
+
+    // The fingerprints of every segment in storage order, computing those dropped
+    const std::vector<uint64_t>&
+    _fingerprint(void) const {
+        if (_powers.size() != uint64_t(_size) + 1) {
+            _hashes.clear();
+            _powers.resize(uint64_t(_size) + 1);
+            _powers[0] = 1;
+            for (S k = 0; k < _size; ++k) {
+                _powers[k + 1] = _mul(_powers[k], _base);
+            }
+        }
+        _repair();
+        for (uint64_t i = _hashes.size(); i < _segments(); ++i) {
+            _hashes.push_back(_hash_segment(_segment(i), std::min<uint64_t>(_size, _len - i * _size)));
+        }
+        return _hashes;
+    }
+
+    /**
+     * Fingerprint upkeep of the physical operations, after the links and anchors are updated.
+     * Only fingerprints that are kept are updated: when they were dropped, they are recomputed
+     * by the next use anyway.
+     */
+    void
+    _hash_push(const T& value) noexcept {
+        uint64_t pos = _len - 1, segment = pos / _size;
+        if (_hashes.empty() or segment > _hashes.size()) {
+            return;
+        }
+        if (segment == _hashes.size()) {
+            if (pos % _size == 0) {
+                try {
+                    _hashes.push_back(_digest(value));
+                } catch (const std::bad_alloc&) {
+                    // Computed by the next use instead
+                }
+            }
+            return;
+        }
+        _hashes[segment] = _add(_hashes[segment], _mul(_digest(value), _powers[pos % _size]));
+    }
+
+    // Before the tail at _len - 1 is unlinked
+    void
+    _hash_pop(const T& value) noexcept {
+        uint64_t pos = _len - 1, segment = pos / _size;
+        if (segment >= _hashes.size()) {
+            return;
+        }
+        if (pos % _size == 0) {
+            _hashes.pop_back();
+        } else {
+            _hashes[segment] = _sub(_hashes[segment], _mul(_digest(value), _powers[pos % _size]));
+        }
+    }
+
+    // A node was linked in at pos: every later segment takes the last value of the one in front
+    // of it, and hands its own last value on if it was full
+    void
+    _hash_insert(uint64_t pos) noexcept {
+        uint64_t first = pos / _size, old = _len - 1, segments = _hashes.size();
+        if (first >= segments) {
+            return;
+        }
+        uint64_t* hashes = _hashes.data();
+        const uint64_t power = _powers[_size];
+        // The value a segment takes is the one the segment in front of it hands on
+        uint64_t digest = first + 1 < segments ? _digest(_segment(first + 1)->value) : 0;
+        for (uint64_t i = first + 1; i < segments; ++i) {
+            uint64_t hash = _add(_mul(hashes[i], _base), digest);
+            if ((i + 1) * _size <= old) {
+                digest = _digest(_segment(i + 1)->value);
+                hash = _sub(hash, _mul(digest, power));
+            }
+            hashes[i] = hash;
+        }
+        hashes[first] = _hash_segment(_segment(first), std::min<uint64_t>(_size, _len - first * _size));
+    }
+
+    // The node at pos was unlinked: every later segment hands its first value to the one in front
+    // of it, and takes the first value of the one behind it if there was one
+    void
+    _hash_erase(uint64_t pos) noexcept {
+        static constexpr uint64_t inverse = _inverse();
+        uint64_t first = pos / _size, old = _len + 1, segments = _segments();
+        _hashes.resize(std::min<uint64_t>(_hashes.size(), segments));
+        // The value a segment hands on is the one the segment in front of it takes
+        uint64_t digest = first + 1 < _hashes.size() ? _digest(_segment(first + 1)->prev->value) : 0;
+        for (uint64_t i = first + 1; i < _hashes.size(); ++i) {
+            uint64_t hash = _mul(_sub(_hashes[i], digest), inverse);
+            if ((i + 1) * _size < old) {
+                const Node* last = i + 1 < segments ? _segment(i + 1)->prev : _refs.back();
+                digest = _digest(last->value);
+                hash = _add(hash, _mul(digest, _powers[_size - 1]));
+            }
+            _hashes[i] = hash;
+        }
+        if (first < _hashes.size()) {
+            _hashes[first] = _hash_segment(_segment(first), std::min<uint64_t>(_size, _len - first * _size));
+        }
+    }
+
+    // Calls f(chunk) for every chunk in [0, threads), chunk 0 on the calling thread, the others on the pool
+    template <class F>
+    static void
+    _run(unsigned threads, F&& f) {
+        if (threads <= 1) {
+            if (threads == 1) {
+                f(0);
+            }
+            return;
+        }
+        DoublyLinkedListPool::instance().run(threads, f);
+    }
+
+    /**
+     * Like _run, but every chunk gets a thread of its own, for chunks that wait for each other
+     * and so must all run at once, which the pool cannot promise
+     */
+    template <class F>
+    static void
+    _spawn(unsigned threads, F&& f) {
+        if (threads <= 1) {
+            if (threads == 1) {
+                f(0);
+            }
+            return;
+        }
+
+        std::vector<std::exception_ptr> errors(threads);
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (unsigned chunk = 1; chunk < threads; ++chunk) {
+            workers.emplace_back([&f, &errors, chunk]() -> void {
+                try {
+                    f(chunk);
+                } catch (...) {
+                    errors[chunk] = std::current_exception();
+                }
+            });
+        }
+        try {
+            f(0);
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        for (const std::exception_ptr& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
     uint64_t _len = 0;
-    // _refs.front() = head, _refs.back() = tail
-    std::vector<Node*> _refs = {nullptr, nullptr};
+    // _refs.front() = head, _refs.back() = tail, both always exact
+    mutable std::vector<Node*> _refs = {nullptr, nullptr};
+    // The anchors between head and tail are stale, see erase
+    mutable bool _dirty = false;
+    // The list runs from _refs.back() to _refs.front() through the prev links, see reverse
+    bool _reversed = false;
+    // Node i in storage order is _refs.front() + i, see compact and _assign
+    bool _contiguous = false;
     // > 0
     S _size;
+    std::vector<Block> _blocks;
+    // Nodes of _blocks.back() handed out so far
+    size_t _used = 0;
+    // Longest the list has been since the pool was last trimmed, see _trim
+    uint64_t _peak = 0;
+    FreeNode* _free = nullptr;
+    // Snapshots that may still share segments with the list
+    std::vector<std::weak_ptr<SnapshotState>> _snapshots;
+    // Fingerprints of the first _hashes.size() segments in storage order, see fingerprint
+    bool _fingerprinted = false;
+    mutable std::vector<uint64_t> _hashes;
+    // _powers[k] = base^k for k <= size, once computed for the current size
+    mutable std::vector<uint64_t> _powers;
+#ifdef DOUBLY_LINKED_LIST_STATS
+    mutable Stats _stats;
+#endif
 };
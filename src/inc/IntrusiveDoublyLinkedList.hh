@@ -0,0 +1,400 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Links embedded in the objects of an IntrusiveDoublyLinkedList, only meaningful while the object is in the list
+template <typename T>
+struct IntrusiveHook {
+    T* prev = nullptr;
+    T* next = nullptr;
+};
+
+/**
+ * @brief doubly linked list of objects that carry their own links, with vector of references to
+ * every size-th object
+ *
+ * @tparam T object type
+ * @tparam Hook the IntrusiveHook<T> member of T that links it into this list
+ * @tparam S size type = unsigned
+ *
+ * The list owns no storage for its elements: it links the objects it is given through their
+ * hook, so pushing and popping never allocate or copy, and at() lands on the object itself rather
+ * than on a node around a copy of it. The objects must outlive their membership, and an object
+ * can be in one list per hook at a time. Only _refs grows, by one pointer per size objects, see
+ * reserve().
+ *
+ * The anchors work as in DoublyLinkedList: at(), insert() and pop() are O(size + length / size).
+ * erase() unlinks an object through its own hook in O(1) and leaves the anchors between head and
+ * tail stale, to be rebuilt in O(length) by the next call that needs positions. That call may be
+ * const, so it must not race with other calls then.
+ *
+ * Constructors:
+ *     - IntrusiveDoublyLinkedList(S size);
+ */
+template <typename T, IntrusiveHook<T> T::*Hook, typename S = unsigned>
+class IntrusiveDoublyLinkedList {
+  public:
+    IntrusiveDoublyLinkedList(S size) : _size(size) { assert(size > 0); }
+
+    // Objects know the list only through their links, which a copy could not share
+    IntrusiveDoublyLinkedList(const IntrusiveDoublyLinkedList&) = delete;
+    IntrusiveDoublyLinkedList& operator=(const IntrusiveDoublyLinkedList&) = delete;
+
+    // Forgets the objects, whose hooks are left as they are
+    void
+    clear(void) noexcept {
+        _refs = {nullptr, nullptr};
+        _len = 0;
+        _dirty = false;
+    }
+
+    // Makes room in _refs for length objects, so that pushing up to there does not allocate
+    void
+    reserve(uint64_t length) {
+        _refs.reserve(_anchors(length));
+    }
+
+    void
+    push_tail(T& object) {
+        ++_len;
+        T* tail = _refs.back();
+        _link(&object, tail, nullptr);
+        if (tail == nullptr) {
+            _refs.front() = _refs.back() = &object;
+            return;
+        }
+        _next(tail) = &object;
+        if (not _dirty and _len > 2 and (_len - 2) % _size == 0) {
+            _refs.push_back(&object);
+        } else {
+            _refs.back() = &object;
+        }
+    }
+
+    void
+    push_head(T& object) {
+        ++_len;
+        T* head = _refs.front();
+        _link(&object, nullptr, head);
+        if (head == nullptr) {
+            _refs.front() = _refs.back() = &object;
+            return;
+        }
+        _prev(head) = &object;
+        if (_dirty) {
+            _refs.front() = &object;
+            return;
+        }
+        for (size_t i = 0; i < _refs.size() - 1; ++i) {
+            _refs[i] = _prev(_refs[i]);
+        }
+        if (_len > 2 and (_len - 2) % _size == 0) {
+            _refs.back() = _prev(_refs.back());
+            _refs.push_back(_next(_refs.back()));
+        }
+    }
+
+    void
+    insert(uint64_t pos, T& object) {
+        if (pos == 0) {
+            return push_head(object);
+        }
+        if (pos == _len) {
+            return push_tail(object);
+        }
+        if (pos > _len) {
+            throw std::out_of_range("pos > length");
+        }
+        T* next = _at(pos);
+        T* prev = _prev(next);
+        _link(&object, prev, next);
+        _next(prev) = _prev(next) = &object;
+        for (size_t i = (pos % _size ? 1 : 0) + pos / _size; i < _refs.size() - 1; ++i) {
+            _refs[i] = _prev(_refs[i]);
+        }
+        ++_len;
+        if (_len > 2 and (_len - 2) % _size == 0) {
+            _refs.back() = _prev(_refs.back());
+            _refs.push_back(_next(_refs.back()));
+        }
+    }
+
+    // nullptr if empty
+    T*
+    pop_tail(void) noexcept {
+        T* object = _refs.back();
+        if (object == nullptr) {
+            return nullptr;
+        }
+        if (--_len == 0) {
+            clear();
+            return object;
+        }
+        _refs.back() = _prev(object);
+        _next(_refs.back()) = nullptr;
+        if (not _dirty and _len > 1 and (_len - 1) % _size == 0) {
+            _refs.pop_back();
+        }
+        return object;
+    }
+
+    // nullptr if empty
+    T*
+    pop_head(void) noexcept {
+        T* object = _refs.front();
+        if (object == nullptr) {
+            return nullptr;
+        }
+        if (--_len == 0) {
+            clear();
+            return object;
+        }
+        _refs.front() = _next(object);
+        _prev(_refs.front()) = nullptr;
+        if (not _dirty) {
+            for (uint64_t i = 1; i < _refs.size() - 1; ++i) {
+                _refs[i] = _next(_refs[i]);
+            }
+            if (_len > 1 and (_len - 1) % _size == 0) {
+                _refs.pop_back();
+            }
+        }
+        return object;
+    }
+
+    T&
+    pop(uint64_t pos) {
+        if (pos >= _len) {
+            throw std::out_of_range("pos >= length");
+        }
+        if (pos == 0) {
+            return *pop_head();
+        }
+        if (pos == _len - 1) {
+            return *pop_tail();
+        }
+        T* object = _at(pos);
+        --_len;
+        _next(_prev(object)) = _next(object);
+        _prev(_next(object)) = _prev(object);
+        for (uint64_t i = (pos % _size ? 1 : 0) + pos / _size; i < _refs.size() - 1; ++i) {
+            _refs[i] = _next(_refs[i]);
+        }
+        if ((_len - 1) % _size == 0) {
+            _refs.pop_back();
+        }
+        return *object;
+    }
+
+    // Unlinks an object of this list through its hook, O(1)
+    void
+    erase(T& object) noexcept {
+        if (&object == _refs.back()) {
+            pop_tail();
+            return;
+        }
+        if (&object == _refs.front()) {
+            _refs.front() = _next(&object);
+            _prev(_refs.front()) = nullptr;
+        } else {
+            _next(_prev(&object)) = _next(&object);
+            _prev(_next(&object)) = _prev(&object);
+        }
+        --_len;
+        // Without interior anchors there is nothing to go stale
+        _dirty = _dirty or _refs.size() > 2 or _anchors(_len) > 2;
+    }
+
+    [[nodiscard]] T&
+    at(uint64_t pos) const {
+        if (pos >= _len) {
+            throw std::out_of_range("pos >= length");
+        }
+        return *_at(pos);
+    }
+
+    [[nodiscard]] constexpr T*
+    head(void) const noexcept {
+        return _refs.front();
+    }
+
+    [[nodiscard]] constexpr T*
+    tail(void) const noexcept {
+        return _refs.back();
+    }
+
+    [[nodiscard]] constexpr bool
+    empty(void) const noexcept {
+        return _len == 0;
+    }
+
+    [[nodiscard]] constexpr uint64_t
+    length(void) const noexcept {
+        return _len;
+    }
+
+    [[nodiscard]] constexpr S
+    size(void) const noexcept {
+        return _size;
+    }
+
+    template <bool Const>
+    class BasicIterator {
+        T* _object;
+
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        explicit BasicIterator(T* object) : _object{object} {}
+
+        [[nodiscard]] constexpr reference
+        operator*() const noexcept {
+            return *_object;
+        }
+
+        [[nodiscard]] constexpr pointer
+        operator->() const noexcept {
+            return _object;
+        }
+
+        constexpr BasicIterator&
+        operator++() noexcept {
+            _object = _next(_object);
+            return *this;
+        }
+
+        constexpr BasicIterator
+        operator++(int) noexcept {
+            BasicIterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        constexpr BasicIterator&
+        operator--() noexcept {
+            _object = _prev(_object);
+            return *this;
+        }
+
+        constexpr BasicIterator
+        operator--(int) noexcept {
+            BasicIterator tmp = *this;
+            --(*this);
+            return tmp;
+        }
+
+        [[nodiscard]] constexpr bool
+        operator==(const BasicIterator& other) const noexcept {
+            return _object == other._object;
+        }
+
+        [[nodiscard]] constexpr bool
+        operator!=(const BasicIterator& other) const noexcept {
+            return !(*this == other);
+        }
+    };
+
+    using Iterator = BasicIterator<false>;
+    using ConstIterator = BasicIterator<true>;
+
+    Iterator
+    begin() {
+        return Iterator(head());
+    }
+
+    Iterator
+    end() {
+        return Iterator(nullptr);
+    }
+
+    ConstIterator
+    begin() const {
+        return cbegin();
+    }
+
+    ConstIterator
+    end() const {
+        return cend();
+    }
+
+    ConstIterator
+    cbegin() const {
+        return ConstIterator(head());
+    }
+
+    ConstIterator
+    cend() const {
+        return ConstIterator(nullptr);
+    }
+
+  private:
+    static T*&
+    _prev(T* object) noexcept {
+        return (object->*Hook).prev;
+    }
+
+    static T*&
+    _next(T* object) noexcept {
+        return (object->*Hook).next;
+    }
+
+    static void
+    _link(T* object, T* prev, T* next) noexcept {
+        _prev(object) = prev;
+        _next(object) = next;
+    }
+
+    // Entries of _refs for a list of length objects
+    [[nodiscard]] uint64_t
+    _anchors(uint64_t length) const noexcept {
+        return length < 2 ? 2 : 2 + (length - 2) / _size;
+    }
+
+    // Recomputes _refs from the links after erase()
+    void
+    _repair(void) const {
+        if (not _dirty) {
+            return;
+        }
+        _dirty = false;
+        T* object = _refs.front();
+        std::vector<T*> refs;
+        refs.reserve(_anchors(_len));
+        for (uint64_t i = 0; _next(object) != nullptr; ++i, object = _next(object)) {
+            if (i % _size == 0) {
+                refs.push_back(object);
+            }
+        }
+        if (refs.empty()) {
+            refs.push_back(object);
+        }
+        refs.push_back(object);
+        _refs.swap(refs);
+    }
+
+    [[nodiscard]] T*
+    _at(uint64_t pos) const {
+        _repair();
+        T* object = _refs[pos / _size];
+        for (S i = 0; i < pos % _size; ++i) {
+            object = _next(object);
+        }
+        return object;
+    }
+
+    S _size;
+    uint64_t _len = 0;
+    // _refs[i] is the object at position i * size, _refs.back() the tail; stale while _dirty
+    mutable std::vector<T*> _refs = {nullptr, nullptr};
+    mutable bool _dirty = false;
+};
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "DoublyLinkedList.hh"
+
+/**
+ * @brief least recently used cache of at most capacity entries
+ *
+ * @tparam K key type
+ * @tparam V value type
+ * @tparam Hash hash function for K = std::hash<K>
+ * @tparam S size type of the underlying DoublyLinkedList = unsigned
+ *
+ * Entries are kept in a DoublyLinkedList from most to least recently used; its nodes are
+ * reserved up front and the node of an evicted entry is reused for the new one. Keys are
+ * found through a flat open addressing table of nodes (linear probing, backward shift
+ * deletion) that stores the full hash next to each node, so a probe only dereferences a node
+ * whose hash matches. get, put and erase are O(1) and put allocates nothing.
+ *
+ * Constructors:
+ *     - LruCache(uint64_t capacity, S size = 64);
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename S = unsigned>
+class LruCache {
+  public:
+    struct Entry {
+        K key;
+        V value;
+    };
+
+    using List = DoublyLinkedList<Entry, S>;
+    using Node = typename List::Node;
+    using ConstIterator = typename List::ConstIterator;
+    using Stats = typename List::Stats;
+
+    LruCache(uint64_t capacity, S size = 64) : _capacity(capacity), _list(size) {
+        assert(capacity > 0);
+        uint64_t slots = 2;
+        for (_shift = 63; slots < 2 * capacity; --_shift) {
+            slots *= 2;
+        }
+        _slots.assign(slots, Slot{0, nullptr});
+        _list.reserve(capacity);
+    }
+
+    // The copy links nodes of its own, so its table is rebuilt to point at them
+    LruCache(const LruCache& other)
+        : _capacity(other._capacity), _list(other._list), _slots(other._slots.size(), Slot{0, nullptr}),
+          _shift(other._shift) {
+        _list.reserve(_capacity);
+        _index();
+    }
+
+    // The nodes move along with the list, so the table stays valid
+    LruCache(LruCache&&) noexcept = default;
+
+    LruCache&
+    operator=(const LruCache& other) {
+        if (this != &other) {
+            _capacity = other._capacity;
+            _list = other._list;
+            _slots.assign(other._slots.size(), Slot{0, nullptr});
+            _shift = other._shift;
+            _list.reserve(_capacity);
+            _index();
+        }
+        return *this;
+    }
+
+    // Value of key marked as most recently used, nullptr if key is not cached
+    [[nodiscard]] V*
+    get(const K& key) {
+        Node* node = _slots[_find(key, Hash{}(key))].node;
+        if (node == nullptr) {
+            return nullptr;
+        }
+        return &_list.move_to_head(node)->value.value;
+    }
+
+    // Like get, without marking key as used
+    [[nodiscard]] const V*
+    peek(const K& key) const {
+        const Node* node = _slots[_find(key, Hash{}(key))].node;
+        return node == nullptr ? nullptr : &node->value.value;
+    }
+
+    [[nodiscard]] bool
+    contains(const K& key) const {
+        return peek(key) != nullptr;
+    }
+
+    // Inserts or overwrites key as most recently used, evicting the least recently used entry if full
+    V&
+    put(const K& key, V value) {
+        size_t hash = Hash{}(key);
+        Slot& slot = _slots[_find(key, hash)];
+        if (slot.node != nullptr) {
+            Node* node = _list.move_to_head(slot.node);
+            node->value.value = std::move(value);
+            return node->value.value;
+        }
+
+        if (_list.length() < _capacity) {
+            // Not push_head, which shifts every anchor: the handle insert only marks them stale
+            slot = {hash, _list.insert_before(_list.head(), Entry{key, std::move(value)})};
+            return slot.node->value.value;
+        }
+        // Recycle the node of the least recently used entry
+        Node* node = _list.tail();
+        _remove(_find(node->value.key, Hash{}(node->value.key)));
+        node->value = Entry{key, std::move(value)};
+        // Removal may have shifted the free slot for key
+        _slots[_find(key, hash)] = {hash, _list.move_to_head(node)};
+        return node->value.value;
+    }
+
+    bool
+    erase(const K& key) {
+        size_t slot = _find(key, Hash{}(key));
+        Node* node = _slots[slot].node;
+        if (node == nullptr) {
+            return false;
+        }
+        _remove(slot);
+        _list.erase(node);
+        if (_list.empty()) {
+            // Emptying the list gave its nodes back
+            _list.reserve(_capacity);
+        }
+        return true;
+    }
+
+    void
+    clear(void) {
+        _list.clear();
+        _list.reserve(_capacity);
+        std::fill(_slots.begin(), _slots.end(), Slot{0, nullptr});
+    }
+
+    [[nodiscard]] constexpr bool
+    empty(void) const noexcept {
+        return _list.empty();
+    }
+
+    [[nodiscard]] constexpr auto
+    length(void) const noexcept {
+        return _list.length();
+    }
+
+    [[nodiscard]] constexpr auto
+    capacity(void) const noexcept {
+        return _capacity;
+    }
+
+    // Counters of the underlying list, see DoublyLinkedList::stats
+    [[nodiscard]] Stats
+    stats(void) const noexcept {
+        return _list.stats();
+    }
+
+    // Entries from most to least recently used
+    ConstIterator
+    begin() const {
+        return _list.cbegin();
+    }
+
+    ConstIterator
+    end() const {
+        return _list.cend();
+    }
+
+  private:
+    struct Slot {
+        size_t hash;
+        // nullptr = empty
+        Node* node;
+    };
+
+    // Fibonacci hashing: hashes such as the identity std::hash of integers would cluster in a linear probing table
+    [[nodiscard]] size_t
+    _home(size_t hash) const noexcept {
+        return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15) >> _shift);
+    }
+
+    // Index of the slot holding key, or of the empty slot where it would go
+    [[nodiscard]] size_t
+    _find(const K& key, size_t hash) const {
+        size_t mask = _slots.size() - 1;
+        for (size_t i = _home(hash);; i = (i + 1) & mask) {
+            const Slot& slot = _slots[i];
+            if (slot.node == nullptr or (slot.hash == hash and slot.node->value.key == key)) {
+                return i;
+            }
+        }
+    }
+
+    // Fills the empty table with the nodes of _list
+    void
+    _index(void) {
+        for (Node* node = _list.head(); node != nullptr; node = node->next) {
+            size_t hash = Hash{}(node->value.key);
+            _slots[_find(node->value.key, hash)] = {hash, node};
+        }
+    }
+
+    // Empties an occupied slot, moving later entries of its probe run back so no tombstones are needed
+    void
+    _remove(size_t hole) noexcept {
+        size_t mask = _slots.size() - 1;
+        for (size_t i = (hole + 1) & mask; _slots[i].node != nullptr; i = (i + 1) & mask) {
+            // An entry may fill the hole if its home slot is not in (hole, i]
+            size_t home = _home(_slots[i].hash);
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                _slots[hole] = _slots[i];
+                hole = i;
+            }
+        }
+        _slots[hole] = {0, nullptr};
+    }
+
+    uint64_t _capacity;
+    List _list;
+    // Power of two, at least twice the capacity
+    std::vector<Slot> _slots;
+    // 64 - log2(_slots.size())
+    unsigned _shift;
+};
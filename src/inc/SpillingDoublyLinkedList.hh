@@ -0,0 +1,443 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief append-mostly list that keeps at most a memory budget of its segments in memory and
+ * spills the others to a backing file
+ *
+ * @tparam T trivially copyable value type
+ * @tparam S size type = unsigned
+ *
+ * The list is cut into segments of size values, like the anchors of DoublyLinkedList. A segment
+ * is either resident, as an array of values, or evicted to its slot in the backing file: segment i
+ * lives at byte i * size * sizeof(T), so neighbouring segments are neighbours in the file. When a
+ * segment has to be paged in and the budget is used up, the clock hand evicts the first resident
+ * segment not accessed since it last came by, writing it back only if it changed since it was read.
+ *
+ * at(), set(), the iterators and for_each() page segments back in transparently. A miss that
+ * continues a sequential scan (and every miss of for_each) reads the evicted segments following
+ * it as well, with one read of the file, up to readahead segments.
+ *
+ * Reads page segments in, so even const calls must not run concurrently.
+ *
+ * Only the tail grows and shrinks: there is no push_head, insert or pop(pos), which would shift
+ * every later segment to the next slot of the file. at() and set() reach any position.
+ *
+ * Constructors:
+ *     - SpillingDoublyLinkedList(S size, uint64_t budget, const std::string& path = "");
+ *       budget in bytes, at least two segments are kept; the backing file is created at path,
+ *       an anonymous temporary file if path is empty
+ */
+template <typename T, typename S = unsigned>
+class SpillingDoublyLinkedList {
+    static_assert(std::is_trivially_copyable_v<T>, "T is written to the backing file byte by byte");
+
+  public:
+    // Segments read ahead at most by one read of the backing file
+    static constexpr uint64_t readahead = 16;
+
+    // Backing file traffic since construction
+    struct Stats {
+        // Reads of the backing file and segments paged in by them
+        uint64_t reads = 0;
+        uint64_t loaded = 0;
+        // Segments written back and evicted
+        uint64_t writes = 0;
+        uint64_t evictions = 0;
+    };
+
+    SpillingDoublyLinkedList(S size, uint64_t budget, const std::string& path = "")
+        : _size(size), _capacity(std::max<uint64_t>(budget / (uint64_t(size) * sizeof(T)), 2)) {
+        assert(size > 0);
+        if (path.empty()) {
+            std::string name = (std::filesystem::temp_directory_path() / "DoublyLinkedList.XXXXXX").string();
+            _fd = mkstemp(name.data());
+            if (_fd != -1) {
+                unlink(name.c_str());
+            }
+        } else {
+            _fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        }
+        if (_fd == -1) {
+            throw std::system_error(errno, std::generic_category(), "cannot create the backing file");
+        }
+    }
+
+    SpillingDoublyLinkedList(const SpillingDoublyLinkedList&) = delete;
+    SpillingDoublyLinkedList& operator=(const SpillingDoublyLinkedList&) = delete;
+
+    ~SpillingDoublyLinkedList() { close(_fd); }
+
+    void
+    clear(void) {
+        _segments.clear();
+        _len = 0;
+        _resident = 0;
+        _hand = npos;
+        _scan = npos;
+        if (ftruncate(_fd, 0) == -1) {
+            throw std::system_error(errno, std::generic_category(), "cannot truncate the backing file");
+        }
+    }
+
+    void
+    push_tail(const T& value) {
+        if (_len % _size == 0) {
+            _reserve(_segments.size(), 1);
+            _segments.push_back({std::unique_ptr<T[]>(new T[_size]), true, true, false, npos, npos});
+            _enter(_segments.size() - 1);
+        } else {
+            _load(_segments.size() - 1, false);
+        }
+        Segment& segment = _segments.back();
+        segment.values[_len++ % _size] = value;
+        segment.dirty = true;
+    }
+
+    T
+    pop_tail(void) {
+        if (_len == 0) {
+            return T();
+        }
+        uint64_t last = _segments.size() - 1;
+        _load(last, false);
+        T result = _segments.back().values[--_len % _size];
+        _segments.back().dirty = true;
+        if (_len % _size == 0) {
+            _leave(last);
+            _segments.pop_back();
+        }
+        return result;
+    }
+
+    [[nodiscard]] T
+    at(uint64_t pos) const {
+        if (pos >= _len) {
+            throw std::out_of_range("pos >= length");
+        }
+        return _value(pos);
+    }
+
+    void
+    set(uint64_t pos, const T& value) {
+        if (pos >= _len) {
+            throw std::out_of_range("pos >= length");
+        }
+        uint64_t i = pos / _size;
+        _load(i, _sequential(i));
+        Segment& segment = _segments[i];
+        segment.values[pos % _size] = value;
+        segment.dirty = true;
+    }
+
+    // Calls f(value) in order, paging segments in readahead at a time
+    template <class F>
+    void
+    for_each(F f) const {
+        for (uint64_t i = 0; i < _segments.size(); ++i) {
+            _load(i, true);
+            const T* values = _segments[i].values.get();
+            for (uint64_t j = 0, n = _count(i); j < n; ++j) {
+                f(values[j]);
+            }
+        }
+    }
+
+    friend std::ostream&
+    operator<<(std::ostream& os, const SpillingDoublyLinkedList<T, S>& list) {
+        os << "head -> ";
+        if (list.empty()) {
+            os << "nullptr";
+        } else {
+            bool first = true;
+            list.for_each([&](const T& value) {
+                os << (first ? "" : " <-> ") << value;
+                first = false;
+            });
+        }
+        os << " <- tail";
+        return os;
+    }
+
+    [[nodiscard]] constexpr bool
+    empty(void) const noexcept {
+        return _len == 0;
+    }
+
+    [[nodiscard]] constexpr auto
+    length(void) const noexcept {
+        return _len;
+    }
+
+    [[nodiscard]] constexpr S
+    size(void) const noexcept {
+        return _size;
+    }
+
+    // Segments that may be resident at once
+    [[nodiscard]] constexpr uint64_t
+    capacity(void) const noexcept {
+        return _capacity;
+    }
+
+    [[nodiscard]] constexpr uint64_t
+    resident(void) const noexcept {
+        return _resident;
+    }
+
+    [[nodiscard]] constexpr Stats
+    stats(void) const noexcept {
+        return _stats;
+    }
+
+    // Values are paged in on the fly, so dereferencing yields a copy
+    class ConstIterator {
+        const SpillingDoublyLinkedList* _list;
+        uint64_t _pos;
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = const T*;
+        using reference = T;
+
+        ConstIterator(const SpillingDoublyLinkedList* list, uint64_t pos) : _list{list}, _pos{pos} {}
+
+        [[nodiscard]] reference
+        operator*() const {
+            return _list->_value(_pos);
+        }
+
+        ConstIterator&
+        operator++() noexcept {
+            ++_pos;
+            return *this;
+        }
+
+        ConstIterator
+        operator++(int) noexcept {
+            ConstIterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        ConstIterator&
+        operator--() noexcept {
+            --_pos;
+            return *this;
+        }
+
+        ConstIterator
+        operator--(int) noexcept {
+            ConstIterator tmp = *this;
+            --(*this);
+            return tmp;
+        }
+
+        [[nodiscard]] bool
+        operator==(const ConstIterator& other) const noexcept {
+            return _pos == other._pos;
+        }
+
+        [[nodiscard]] bool
+        operator!=(const ConstIterator& other) const noexcept {
+            return !(*this == other);
+        }
+    };
+
+    ConstIterator
+    begin() const {
+        return cbegin();
+    }
+
+    ConstIterator
+    end() const {
+        return cend();
+    }
+
+    ConstIterator
+    cbegin() const {
+        return ConstIterator(this, 0);
+    }
+
+    ConstIterator
+    cend() const {
+        return ConstIterator(this, _len);
+    }
+
+  private:
+    static constexpr uint64_t npos = ~uint64_t(0);
+
+    struct Segment {
+        // nullptr while evicted
+        std::unique_ptr<T[]> values;
+        // Differs from its slot in the backing file
+        bool dirty;
+        // Accessed since the clock hand last came by
+        bool referenced;
+        // Has a slot in the backing file, which is only written on eviction
+        bool stored;
+        // Neighbours in the clock while resident
+        uint64_t prev;
+        uint64_t next;
+    };
+
+    // Values in segment i
+    [[nodiscard]] uint64_t
+    _count(uint64_t i) const noexcept {
+        return i + 1 < _segments.size() ? _size : _len - i * _size;
+    }
+
+    [[nodiscard]] off_t
+    _offset(uint64_t i) const noexcept {
+        return static_cast<off_t>(i * _size * sizeof(T));
+    }
+
+    // Whether a miss of segment i continues a scan
+    [[nodiscard]] bool
+    _sequential(uint64_t i) const noexcept {
+        return i == _scan + 1;
+    }
+
+    [[nodiscard]] T
+    _value(uint64_t pos) const {
+        uint64_t i = pos / _size;
+        _load(i, _sequential(i));
+        return _segments[i].values[pos % _size];
+    }
+
+    // Pages segment i in, with the evicted segments after it if batch
+    void
+    _load(uint64_t i, bool batch) const {
+        Segment& first = _segments[i];
+        first.referenced = true;
+        if (first.values != nullptr) {
+            return;
+        }
+        uint64_t n = 1;
+        for (uint64_t limit = batch ? std::min(readahead, _capacity / 2) : 1;
+             n < limit and i + n < _segments.size() and _segments[i + n].values == nullptr; ++n) {
+        }
+        _reserve(i, n);
+
+        std::vector<std::unique_ptr<T[]>> buffers(n);
+        std::vector<iovec> parts(n);
+        size_t bytes = 0;
+        for (uint64_t j = 0; j < n; ++j) {
+            buffers[j].reset(new T[_size]);
+            parts[j] = {buffers[j].get(), _count(i + j) * sizeof(T)};
+            bytes += parts[j].iov_len;
+        }
+        ssize_t got = preadv(_fd, parts.data(), static_cast<int>(n), _offset(i));
+        if (got != static_cast<ssize_t>(bytes)) {
+            throw std::system_error(got == -1 ? errno : EIO, std::generic_category(), "cannot read the backing file");
+        }
+        ++_stats.reads;
+        _stats.loaded += n;
+        for (uint64_t j = 0; j < n; ++j) {
+            Segment& segment = _segments[i + j];
+            segment.values = std::move(buffers[j]);
+            segment.dirty = false;
+            segment.referenced = j == 0;
+            _enter(i + j);
+        }
+        _scan = i + n - 1;
+    }
+
+    // Evicts segments until n more fit, sparing [first, first + n)
+    void
+    _reserve(uint64_t first, uint64_t n) const {
+        // Every resident segment is passed at most twice per eviction, clearing its reference bit once
+        for (uint64_t steps = 0; _resident + n > _capacity and steps < 2 * _resident; ++steps) {
+            uint64_t i = _hand;
+            Segment& segment = _segments[i];
+            if (i >= first and i < first + n) {
+                _hand = segment.next;
+            } else if (segment.referenced) {
+                segment.referenced = false;
+                _hand = segment.next;
+            } else {
+                _evict(i);
+                _leave(i);
+                steps = 0;
+            }
+        }
+    }
+
+    // Adds the resident segment i to the clock, just behind the hand so that it is looked at last
+    void
+    _enter(uint64_t i) const {
+        Segment& segment = _segments[i];
+        if (_resident++ == 0) {
+            segment.prev = segment.next = _hand = i;
+            return;
+        }
+        segment.prev = _segments[_hand].prev;
+        segment.next = _hand;
+        _segments[segment.prev].next = _segments[_hand].prev = i;
+    }
+
+    // Takes segment i out of the clock, the hand moves on to the next one if it was at i
+    void
+    _leave(uint64_t i) const {
+        Segment& segment = _segments[i];
+        if (--_resident == 0) {
+            _hand = npos;
+            return;
+        }
+        _segments[segment.prev].next = segment.next;
+        _segments[segment.next].prev = segment.prev;
+        _hand = _hand == i ? segment.next : _hand;
+    }
+
+    void
+    _evict(uint64_t i) const {
+        Segment& segment = _segments[i];
+        if (segment.dirty or not segment.stored) {
+            size_t bytes = _count(i) * sizeof(T);
+            ssize_t written = pwrite(_fd, segment.values.get(), bytes, _offset(i));
+            if (written != static_cast<ssize_t>(bytes)) {
+                throw std::system_error(written == -1 ? errno : EIO, std::generic_category(),
+                                        "cannot write the backing file");
+            }
+            ++_stats.writes;
+            segment.stored = true;
+        }
+        segment.values.reset();
+        segment.dirty = false;
+        ++_stats.evictions;
+    }
+
+    S _size;
+    // Resident segments at most
+    uint64_t _capacity;
+    int _fd = -1;
+    uint64_t _len = 0;
+    // Paging changes which segments are resident, not the values
+    mutable std::vector<Segment> _segments;
+    // Resident segments, linked into a ring in clock order through Segment::prev and next, and the
+    // one the hand looks at next
+    mutable uint64_t _resident = 0;
+    mutable uint64_t _hand = npos;
+    // Last segment paged in
+    mutable uint64_t _scan = npos;
+    mutable Stats _stats;
+};
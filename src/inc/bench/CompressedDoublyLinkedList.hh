@@ -0,0 +1,91 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "../CompressedDoublyLinkedList.hh"
+#include "../DoublyLinkedList.hh"
+
+using Compressed = CompressedDoublyLinkedList<uint64_t>;
+
+// Microsecond timestamps about a millisecond apart
+std::vector<uint64_t>
+timestamps(int64_t length) {
+    std::mt19937_64 random(length);
+    std::vector<uint64_t> vec(length);
+    uint64_t time = 1700000000000000;
+    for (uint64_t& value : vec) {
+        value = time += 1000 + random() % 256;
+    }
+    return vec;
+}
+
+template <class C>
+C
+make_timestamps(int64_t length) {
+    std::vector<uint64_t> vec = timestamps(length);
+    return C(64, vec.begin(), vec.end());
+}
+
+template <class C>
+double
+bytes_per_value(const C& c) {
+    if constexpr (std::is_same_v<C, Compressed>) {
+        return static_cast<double>(c.memory_usage()) / static_cast<double>(c.length());
+    } else {
+        return sizeof(typename C::Node) + static_cast<double>(sizeof(typename C::Node*)) / c.size();
+    }
+}
+
+template <class C>
+void
+BM_TimestampsIterate(benchmark::State& state) {
+    const C c = make_timestamps<C>(state.range(0));
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        if constexpr (std::is_same_v<C, Compressed>) {
+            c.for_each([&](uint64_t value) { sum += value; });
+        } else {
+            c.for_each(C::seq, [&](uint64_t value) { sum += value; });
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes_per_value"] = bytes_per_value(c);
+}
+
+template <class C>
+void
+BM_TimestampsAt(benchmark::State& state) {
+    C c = make_timestamps<C>(state.range(0));
+    std::mt19937_64 random(0);
+    for (auto _ : state) {
+        if constexpr (std::is_same_v<C, Compressed>) {
+            benchmark::DoNotOptimize(c.at(random() % state.range(0)));
+        } else {
+            benchmark::DoNotOptimize(c.at(random() % state.range(0))->value);
+        }
+    }
+}
+
+// A late sample inserted at a random position and popped again, which re-encodes one block twice
+template <class C>
+void
+BM_TimestampsInsertPop(benchmark::State& state) {
+    C c = make_timestamps<C>(state.range(0));
+    std::mt19937_64 random(0);
+    for (auto _ : state) {
+        uint64_t pos = random() % state.range(0);
+        c.insert(pos, 1700000000000000);
+        benchmark::DoNotOptimize(c.pop(pos));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_TimestampsIterate, Compressed)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(BM_TimestampsIterate, DoublyLinkedList<uint64_t>)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(BM_TimestampsAt, Compressed)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(BM_TimestampsAt, DoublyLinkedList<uint64_t>)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(BM_TimestampsInsertPop, Compressed)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(BM_TimestampsInsertPop, DoublyLinkedList<uint64_t>)->Arg(1 << 22);
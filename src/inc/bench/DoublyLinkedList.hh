@@ -0,0 +1,585 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../DoublyLinkedList.hh"
+
+using List = DoublyLinkedList<uint64_t>;
+
+const unsigned SIZE = 64;
+// Sweeps: list length and, for DoublyLinkedList only, the size anchor spacing
+const std::vector<int64_t> LENGTHS = {1 << 10, 1 << 14, 1 << 18};
+const std::vector<int64_t> SIZES = {8, 64, 512};
+
+// 4Mi nodes of 24 bytes are far larger than the last level cache
+const int64_t SMALL = 1 << 16;
+const int64_t LARGE = 1 << 22;
+
+template <class C>
+constexpr bool is_list = std::is_same_v<C, List>;
+
+std::vector<uint64_t>
+random_values(int64_t length) {
+    std::mt19937_64 random(length);
+    std::vector<uint64_t> vec(length);
+    for (uint64_t& value : vec) {
+        value = random();
+    }
+    return vec;
+}
+
+template <class C>
+void
+sweep(benchmark::internal::Benchmark* bench) {
+    for (int64_t length : LENGTHS) {
+        if constexpr (is_list<C>) {
+            for (int64_t size : SIZES) {
+                bench->Args({length, size});
+            }
+        } else {
+            bench->Args({length});
+        }
+    }
+}
+
+template <class C>
+C
+make(const benchmark::State& state, const std::vector<uint64_t>& vec = {}) {
+    if constexpr (is_list<C>) {
+        return C(static_cast<unsigned>(state.range(1)), vec.begin(), vec.end());
+    } else {
+        return C(vec.begin(), vec.end());
+    }
+}
+
+template <class C>
+void
+push_head(C& c, uint64_t value) {
+    if constexpr (is_list<C>) {
+        c.push_head(value);
+    } else {
+        c.push_front(value);
+    }
+}
+
+template <class C>
+void
+push_tail(C& c, uint64_t value) {
+    if constexpr (is_list<C>) {
+        c.push_tail(value);
+    } else {
+        c.push_back(value);
+    }
+}
+
+template <class C>
+void
+insert(C& c, uint64_t pos, uint64_t value) {
+    if constexpr (is_list<C>) {
+        c.insert(pos, value);
+    } else {
+        c.insert(std::next(c.begin(), pos), value);
+    }
+}
+
+template <class C>
+uint64_t
+pop_head(C& c) {
+    if constexpr (is_list<C>) {
+        return c.pop_head();
+    } else {
+        uint64_t value = c.front();
+        c.pop_front();
+        return value;
+    }
+}
+
+template <class C>
+uint64_t
+pop_tail(C& c) {
+    if constexpr (is_list<C>) {
+        return c.pop_tail();
+    } else {
+        uint64_t value = c.back();
+        c.pop_back();
+        return value;
+    }
+}
+
+template <class C>
+uint64_t
+pop(C& c, uint64_t pos) {
+    if constexpr (is_list<C>) {
+        return c.pop(pos);
+    } else {
+        auto it = std::next(c.begin(), pos);
+        uint64_t value = *it;
+        c.erase(it);
+        return value;
+    }
+}
+
+template <class C>
+uint64_t
+at(const C& c, uint64_t pos) {
+    if constexpr (is_list<C>) {
+        return c.at(pos)->value;
+    } else {
+        return *std::next(c.begin(), pos);
+    }
+}
+
+template <class C>
+void
+sort(C& c) {
+    if constexpr (is_list<C>) {
+        c.sort();
+    } else if constexpr (std::is_same_v<C, std::list<uint64_t>>) {
+        c.sort();
+    } else {
+        std::sort(c.begin(), c.end());
+    }
+}
+
+template <class C>
+void
+BM_Construct(benchmark::State& state) {
+    std::vector<uint64_t> vec = random_values(state.range(0));
+    for (auto _ : state) {
+        C c = make<C>(state, vec);
+        benchmark::DoNotOptimize(&c);
+        state.PauseTiming();
+        c = make<C>(state);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <class C>
+void
+BM_PushHead(benchmark::State& state) {
+    for (auto _ : state) {
+        C c = make<C>(state);
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            push_head(c, i);
+        }
+        state.PauseTiming();
+        c = make<C>(state);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <class C>
+void
+BM_PushTail(benchmark::State& state) {
+    for (auto _ : state) {
+        C c = make<C>(state);
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            push_tail(c, i);
+        }
+        state.PauseTiming();
+        c = make<C>(state);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <class C>
+void
+BM_PopHead(benchmark::State& state) {
+    std::vector<uint64_t> vec = random_values(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        C c = make<C>(state, vec);
+        state.ResumeTiming();
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            benchmark::DoNotOptimize(pop_head(c));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <class C>
+void
+BM_PopTail(benchmark::State& state) {
+    std::vector<uint64_t> vec = random_values(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        C c = make<C>(state, vec);
+        state.ResumeTiming();
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            benchmark::DoNotOptimize(pop_tail(c));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// insert and pop at random positions, in pairs so that the length stays the same
+template <class C>
+void
+BM_InsertPop(benchmark::State& state) {
+    C c = make<C>(state, random_values(state.range(0)));
+    std::mt19937_64 random(0);
+    for (auto _ : state) {
+        insert(c, random() % state.range(0), 0);
+        benchmark::DoNotOptimize(pop(c, random() % state.range(0)));
+    }
+}
+
+template <class C>
+void
+BM_At(benchmark::State& state) {
+    C c = make<C>(state, random_values(state.range(0)));
+    std::mt19937_64 random(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at(c, random() % state.range(0)));
+    }
+}
+
+template <class C>
+void
+BM_Iterate(benchmark::State& state) {
+    C c = make<C>(state, random_values(state.range(0)));
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (uint64_t value : c) {
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <class C>
+void
+BM_Sort(benchmark::State& state) {
+    std::vector<uint64_t> vec = random_values(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        C c = make<C>(state, vec);
+        state.ResumeTiming();
+        sort(c);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Round robin: the head moves to the tail
+template <class C>
+void
+BM_Rotate(benchmark::State& state) {
+    C c = make<C>(state, random_values(state.range(0)));
+    for (auto _ : state) {
+        if constexpr (is_list<C>) {
+            c.rotate(1);
+        } else if constexpr (std::is_same_v<C, std::list<uint64_t>>) {
+            c.splice(c.end(), c, c.begin());
+        } else {
+            c.push_back(c.front());
+            c.pop_front();
+        }
+        benchmark::DoNotOptimize(&c);
+    }
+}
+
+// Rebuilds _refs, alternating between size and 2 * size
+void
+BM_Resize(benchmark::State& state) {
+    List list = make<List>(state, random_values(state.range(0)));
+    unsigned size = static_cast<unsigned>(state.range(1));
+    for (auto _ : state) {
+        list.resize(list.size() == size ? 2 * size : size);
+    }
+}
+
+template <class C>
+void
+BM_Output(benchmark::State& state) {
+    C c = make<C>(state, random_values(state.range(0)));
+    for (auto _ : state) {
+        std::ostringstream os;
+        if constexpr (is_list<C>) {
+            os << c;
+        } else {
+            for (uint64_t value : c) {
+                os << value << '\n';
+            }
+        }
+        benchmark::DoNotOptimize(os.tellp());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <class C>
+void
+BM_Input(benchmark::State& state) {
+    std::ostringstream os;
+    for (uint64_t value : random_values(state.range(0))) {
+        os << value << '\n';
+    }
+    const std::string text = os.str();
+    for (auto _ : state) {
+        C c = make<C>(state);
+        std::istringstream is(text);
+        if constexpr (is_list<C>) {
+            c.from_string = [](const std::string& line) -> uint64_t { return std::stoull(line); };
+            is >> c;
+        } else {
+            for (std::string line; std::getline(is, line);) {
+                c.push_back(std::stoull(line));
+            }
+        }
+        benchmark::DoNotOptimize(&c);
+        state.PauseTiming();
+        c = make<C>(state);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Parallel reduce on range(1) threads, small lists show what starting the work costs
+void
+BM_ReduceParallel(benchmark::State& state) {
+    std::vector<uint64_t> vec = random_values(state.range(0));
+    List list(SIZE, vec.begin(), vec.end());
+    List::Parallel policy{static_cast<unsigned>(state.range(1))};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.reduce(policy, uint64_t(0), std::plus<>()));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// ingest with range(1) parser threads, against operator>> above
+void
+BM_Ingest(benchmark::State& state) {
+    std::ostringstream os;
+    for (uint64_t value : random_values(state.range(0))) {
+        os << value << '\n';
+    }
+    const std::string text = os.str();
+    for (auto _ : state) {
+        List list(SIZE);
+        list.from_string = [](const std::string& line) -> uint64_t { return std::stoull(line); };
+        std::istringstream is(text);
+        benchmark::DoNotOptimize(list.ingest(is, static_cast<unsigned>(state.range(1))).get());
+        state.PauseTiming();
+        list.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// range(2) random inserts and pops, by apply_batch if range(3) or one at a time otherwise
+void
+BM_ApplyBatch(benchmark::State& state) {
+    List list = make<List>(state, random_values(state.range(0)));
+    std::mt19937_64 random(0);
+    std::vector<List::Op> ops;
+    for (int64_t i = 0; i < state.range(2); i += 2) {
+        ops.push_back({List::Op::insert, random() % state.range(0), 0});
+        ops.push_back({List::Op::pop, random() % state.range(0)});
+    }
+    for (auto _ : state) {
+        if (state.range(3)) {
+            benchmark::DoNotOptimize(list.apply_batch(ops.begin(), ops.end()));
+        } else {
+            for (const List::Op& op : ops) {
+                if (op.kind == List::Op::insert) {
+                    list.insert(op.pos, op.value);
+                } else {
+                    benchmark::DoNotOptimize(list.pop(op.pos));
+                }
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(2));
+}
+
+// Sums SIZE values from a random position, opened by slice() if range(1) or by walking from begin() otherwise
+void
+BM_Slice(benchmark::State& state) {
+    std::vector<uint64_t> vec = random_values(state.range(0));
+    List list(SIZE, vec.begin(), vec.end());
+    std::mt19937_64 random(0);
+    for (auto _ : state) {
+        uint64_t pos = random() % (state.range(0) - SIZE);
+        auto first = state.range(1) ? list.slice(pos, SIZE).begin() : std::next(list.begin(), pos);
+        benchmark::DoNotOptimize(std::accumulate(first, std::next(first, SIZE), uint64_t(0)));
+    }
+}
+
+// Replicas that drifted apart by one insert and pop in the middle, compared by fingerprints if range(1)
+void
+BM_Diff(benchmark::State& state) {
+    std::vector<uint64_t> vec = random_values(state.range(0));
+    List list(SIZE, vec.begin(), vec.end()), replica(SIZE, vec.begin(), vec.end());
+    list.fingerprint(state.range(1));
+    replica.fingerprint(state.range(1));
+    list.insert(state.range(0) / 2, 0);
+    list.pop(state.range(0) / 2 + SIZE);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.diff(replica));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#define BENCHMARK_CONTAINERS(bench)                                                                                    \
+    BENCHMARK_TEMPLATE(bench, List)->Apply(sweep<List>);                                                               \
+    BENCHMARK_TEMPLATE(bench, std::list<uint64_t>)->Apply(sweep<std::list<uint64_t>>);                                 \
+    BENCHMARK_TEMPLATE(bench, std::deque<uint64_t>)->Apply(sweep<std::deque<uint64_t>>);                               \
+    BENCHMARK_TEMPLATE(bench, std::vector<uint64_t>)->Apply(sweep<std::vector<uint64_t>>)
+
+// std::vector has no push_front/pop_front
+#define BENCHMARK_CONTAINERS_HEAD(bench)                                                                               \
+    BENCHMARK_TEMPLATE(bench, List)->Apply(sweep<List>);                                                               \
+    BENCHMARK_TEMPLATE(bench, std::list<uint64_t>)->Apply(sweep<std::list<uint64_t>>);                                 \
+    BENCHMARK_TEMPLATE(bench, std::deque<uint64_t>)->Apply(sweep<std::deque<uint64_t>>)
+
+BENCHMARK_CONTAINERS(BM_Construct);
+BENCHMARK_CONTAINERS_HEAD(BM_PushHead);
+BENCHMARK_CONTAINERS(BM_PushTail);
+BENCHMARK_CONTAINERS_HEAD(BM_PopHead);
+BENCHMARK_CONTAINERS(BM_PopTail);
+BENCHMARK_CONTAINERS(BM_InsertPop);
+BENCHMARK_CONTAINERS(BM_At);
+BENCHMARK_CONTAINERS(BM_Iterate);
+BENCHMARK_CONTAINERS(BM_Sort);
+BENCHMARK_CONTAINERS_HEAD(BM_Rotate);
+BENCHMARK(BM_Resize)->Apply(sweep<List>);
+BENCHMARK_CONTAINERS(BM_Output);
+BENCHMARK_CONTAINERS(BM_Input);
+BENCHMARK(BM_ReduceParallel)->ArgsProduct({{1 << 12, SMALL, LARGE}, {2, 4}})->UseRealTime();
+BENCHMARK(BM_Ingest)->ArgsProduct({{1 << 18, LARGE}, {1, 2, 4}})->UseRealTime();
+BENCHMARK(BM_Slice)->ArgsProduct({{SMALL, LARGE}, {0, 1}});
+BENCHMARK(BM_Diff)->ArgsProduct({{SMALL, LARGE}, {0, 1}});
+BENCHMARK(BM_ApplyBatch)->ArgsProduct({{1 << 18}, {SIZE}, {1 << 8, 1 << 12, 1 << 16}, {0, 1}});
+
+// Traversals over nodes scattered across the heap (sort() relinks them into the order of random
+// values) versus the same list after compact(); build with PREFETCH=1 to compare prefetching
+List
+scattered(int64_t length) {
+    std::vector<uint64_t> vec = random_values(length);
+    List list(SIZE, vec.begin(), vec.end());
+    list.sort();
+    return list;
+}
+
+List
+compacted(int64_t length) {
+    List list = scattered(length);
+    list.compact();
+    return list;
+}
+
+// compacted() with room left for its last eighth, which is appended afterwards
+List
+appended(int64_t length) {
+    std::vector<uint64_t> vec = random_values(length);
+    List list(SIZE, vec.begin(), vec.end() - length / 8);
+    list.sort();
+    list.compact(length / 8);
+    for (auto it = vec.end() - length / 8; it != vec.end(); ++it) {
+        list.push_tail(*it);
+    }
+    return list;
+}
+
+template <List (*Make)(int64_t)>
+void
+BM_Scan(benchmark::State& state) {
+    List list = Make(state.range(0));
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (uint64_t value : list) {
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <List (*Make)(int64_t)>
+void
+BM_ScanReduce(benchmark::State& state) {
+    List list = Make(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.reduce(list.seq, uint64_t(0), std::plus<>()));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <List (*Make)(int64_t)>
+void
+BM_ScanAt(benchmark::State& state) {
+    List list = Make(state.range(0));
+    std::mt19937_64 random(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.at(random() % list.length()));
+    }
+}
+
+template <List (*Make)(int64_t)>
+void
+BM_ScanEqual(benchmark::State& state) {
+    List list1 = Make(state.range(0)), list2 = Make(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list1 == list2);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Lookup of a value that is not there, a full scan
+template <List (*Make)(int64_t)>
+void
+BM_ScanFind(benchmark::State& state) {
+    List list = Make(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.find(0));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <List (*Make)(int64_t)>
+void
+BM_ScanCount(benchmark::State& state) {
+    List list = Make(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.count(0));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <List (*Make)(int64_t)>
+void
+BM_ScanSum(benchmark::State& state) {
+    List list = Make(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.sum());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Scan<scattered>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_Scan<compacted>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanReduce<scattered>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanReduce<compacted>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanAt<scattered>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanAt<compacted>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanEqual<scattered>)->Arg(LARGE);
+BENCHMARK(BM_ScanEqual<compacted>)->Arg(LARGE);
+BENCHMARK(BM_ScanFind<scattered>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanFind<compacted>)->Arg(1 << 12)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanFind<appended>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanCount<scattered>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanCount<compacted>)->Arg(1 << 12)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanSum<scattered>)->Arg(SMALL)->Arg(LARGE);
+BENCHMARK(BM_ScanSum<compacted>)->Arg(SMALL)->Arg(LARGE);
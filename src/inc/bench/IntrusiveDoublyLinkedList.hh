@@ -0,0 +1,67 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "../DoublyLinkedList.hh"
+#include "../IntrusiveDoublyLinkedList.hh"
+
+// An object that lives in an arena of its own, like the orders of a book
+struct Order {
+    uint64_t id;
+    uint64_t fields[6];
+    IntrusiveHook<Order> hook;
+};
+
+using Orders = IntrusiveDoublyLinkedList<Order, &Order::hook>;
+const int64_t ORDERS = 1 << 18;
+
+std::vector<Order>
+make_orders(int64_t count) {
+    std::vector<Order> orders(count);
+    for (int64_t i = 0; i < count; ++i) {
+        orders[i].id = static_cast<uint64_t>(i);
+    }
+    return orders;
+}
+
+// Fills the list with every order and empties it again, by reference or by copy into nodes
+template <class C>
+void
+BM_OrdersPushPop(benchmark::State& state) {
+    std::vector<Order> orders = make_orders(state.range(0));
+    C c(64);
+    for (auto _ : state) {
+        for (Order& order : orders) {
+            c.push_tail(order);
+        }
+        while (not c.empty()) {
+            benchmark::DoNotOptimize(c.pop_tail());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <class C>
+void
+BM_OrdersAt(benchmark::State& state) {
+    std::vector<Order> orders = make_orders(state.range(0));
+    C c(64);
+    for (Order& order : orders) {
+        c.push_tail(order);
+    }
+    std::mt19937_64 random(0);
+    for (auto _ : state) {
+        if constexpr (std::is_same_v<C, Orders>) {
+            benchmark::DoNotOptimize(c.at(random() % state.range(0)).id);
+        } else {
+            benchmark::DoNotOptimize(c.at(random() % state.range(0))->value.id);
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_OrdersPushPop, Orders)->Arg(ORDERS);
+BENCHMARK_TEMPLATE(BM_OrdersPushPop, DoublyLinkedList<Order>)->Arg(ORDERS);
+BENCHMARK_TEMPLATE(BM_OrdersAt, Orders)->Arg(ORDERS);
+BENCHMARK_TEMPLATE(BM_OrdersAt, DoublyLinkedList<Order>)->Arg(ORDERS);
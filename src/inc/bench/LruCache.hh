@@ -0,0 +1,110 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../LruCache.hh"
+
+// Caches of capacity entries looked up with keys from 4 * capacity; 90% of the lookups hit the hottest tenth
+const std::vector<int64_t> CAPACITIES = {1 << 10, 1 << 16};
+const int64_t LOOKUPS = 1 << 20;
+
+std::vector<uint64_t>
+lookup_keys(int64_t capacity) {
+    std::mt19937_64 random(capacity);
+    std::vector<uint64_t> keys(LOOKUPS);
+    uint64_t space = 4 * capacity;
+    for (uint64_t& key : keys) {
+        key = random() % 10 ? random() % (space / 10) : random() % space;
+    }
+    return keys;
+}
+
+using Lru = LruCache<uint64_t, uint64_t>;
+
+// What we wrote by hand before LruCache: DoublyLinkedList plus std::unordered_map of its nodes
+class HandRolledLru {
+  public:
+    using List = DoublyLinkedList<std::pair<uint64_t, uint64_t>>;
+
+    HandRolledLru(uint64_t capacity) : _capacity(capacity), _list(64) { _index.reserve(capacity); }
+
+    uint64_t*
+    get(uint64_t key) {
+        auto it = _index.find(key);
+        return it == _index.end() ? nullptr : &_list.move_to_head(it->second)->value.second;
+    }
+
+    void
+    put(uint64_t key, uint64_t value) {
+        if (_list.length() == _capacity) {
+            _index.erase(_list.tail()->value.first);
+            _list.pop_tail();
+        }
+        _index[key] = _list.push_head({key, value});
+    }
+
+  private:
+    uint64_t _capacity;
+    List _list;
+    std::unordered_map<uint64_t, List::Node*> _index;
+};
+
+class StdLru {
+  public:
+    StdLru(uint64_t capacity) : _capacity(capacity) { _index.reserve(capacity); }
+
+    uint64_t*
+    get(uint64_t key) {
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            return nullptr;
+        }
+        _list.splice(_list.begin(), _list, it->second);
+        return &it->second->second;
+    }
+
+    void
+    put(uint64_t key, uint64_t value) {
+        if (_list.size() == _capacity) {
+            _index.erase(_list.back().first);
+            _list.pop_back();
+        }
+        _list.emplace_front(key, value);
+        _index[key] = _list.begin();
+    }
+
+  private:
+    uint64_t _capacity;
+    std::list<std::pair<uint64_t, uint64_t>> _list;
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, uint64_t>>::iterator> _index;
+};
+
+// get, on a miss put
+template <class Cache>
+void
+BM_Lru(benchmark::State& state) {
+    std::vector<uint64_t> keys = lookup_keys(state.range(0));
+    Cache cache(state.range(0));
+    uint64_t hits = 0;
+    for (auto _ : state) {
+        for (uint64_t key : keys) {
+            if (uint64_t* value = cache.get(key)) {
+                ++*value;
+                ++hits;
+            } else {
+                cache.put(key, key);
+            }
+        }
+    }
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations() * LOOKUPS);
+    state.counters["hit_rate"] = static_cast<double>(hits) / static_cast<double>(state.iterations() * LOOKUPS);
+}
+
+BENCHMARK_TEMPLATE(BM_Lru, Lru)->ArgsProduct({CAPACITIES});
+BENCHMARK_TEMPLATE(BM_Lru, HandRolledLru)->ArgsProduct({CAPACITIES});
+BENCHMARK_TEMPLATE(BM_Lru, StdLru)->ArgsProduct({CAPACITIES});
@@ -0,0 +1,146 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <memory>
+#include <numeric>
+#include <vector>
+#include "../BoundedDoublyLinkedList.hh"
+
+TEST(Bounded, PushTail_Evict) {
+    BoundedDoublyLinkedList<int> list(4);
+
+    for (int i = 0; i < 10; i++) {
+        list.push_tail(i);
+        ASSERT_EQ(list.length(), std::min(i + 1, 4));
+        ASSERT_EQ(list.tail()->value, i);
+    }
+
+    ASSERT_TRUE(list.full());
+    ASSERT_EQ(std::vector<int>(list.begin(), list.end()), std::vector<int>({6, 7, 8, 9}));
+    ASSERT_EQ(std::vector<int>(list.rbegin(), list.rend()), std::vector<int>({9, 8, 7, 6}));
+    ASSERT_EQ(list.head()->prev, nullptr);
+    ASSERT_EQ(list.tail()->next, nullptr);
+}
+
+TEST(Bounded, PushHead_Evict) {
+    BoundedDoublyLinkedList<int> list(3);
+
+    for (int i = 0; i < 7; i++) {
+        list.push_head(i);
+    }
+    list.push_tail(-1);
+
+    ASSERT_EQ(std::vector<int>(list.begin(), list.end()), std::vector<int>({5, 4, -1}));
+    ASSERT_EQ(std::vector<int>(list.rbegin(), list.rend()), std::vector<int>({-1, 4, 5}));
+}
+
+TEST(Bounded, At_) {
+    BoundedDoublyLinkedList<unsigned> list(5);
+
+    for (unsigned i = 0; i < 13; i++) {
+        list.push_tail(i);
+        for (unsigned j = 0; j < list.length(); j++) {
+            ASSERT_EQ(list.at(j)->value, i + 1 - list.length() + j);
+        }
+    }
+
+    ASSERT_THROW(static_cast<void>(list.at(5)), std::out_of_range);
+}
+
+TEST(Bounded, Pop_) {
+    BoundedDoublyLinkedList<int> list(4);
+
+    ASSERT_EQ(list.pop_head(), 0);
+    ASSERT_EQ(list.pop_tail(), 0);
+
+    for (int i = 0; i < 6; i++) {
+        list.push_tail(i);
+    }
+    ASSERT_EQ(list.pop_head(), 2);
+    ASSERT_EQ(list.pop_tail(), 5);
+    ASSERT_EQ(list.length(), 2u);
+    ASSERT_EQ(list.head()->prev, nullptr);
+    ASSERT_EQ(list.tail()->next, nullptr);
+
+    list.push_head(1);
+    list.push_tail(6);
+    list.push_tail(7);
+    ASSERT_EQ(std::vector<int>(list.begin(), list.end()), std::vector<int>({3, 4, 6, 7}));
+
+    while (!list.empty()) {
+        list.pop_tail();
+    }
+    ASSERT_EQ(list.head(), nullptr);
+    ASSERT_EQ(list.begin(), list.end());
+}
+
+TEST(Bounded, SlidingWindow) {
+    const unsigned WINDOW = 16;
+    BoundedDoublyLinkedList<uint64_t> list(WINDOW);
+    uint64_t sum = 0;
+
+    for (uint64_t i = 1; i <= 1000; i++) {
+        if (list.full()) {
+            sum -= list.head()->value;
+        }
+        list.push_tail(i);
+        sum += i;
+        ASSERT_EQ(sum, std::accumulate(list.begin(), list.end(), uint64_t(0)));
+    }
+    ASSERT_EQ(sum, (985 + 1000) * WINDOW / 2);
+}
+
+TEST(Bounded, Capacity_One) {
+    BoundedDoublyLinkedList<int> list(1);
+
+    list.push_tail(1);
+    list.push_head(2);
+    list.push_tail(3);
+    ASSERT_EQ(list.length(), 1u);
+    ASSERT_EQ(list.head(), list.tail());
+    ASSERT_EQ(list.head()->value, 3);
+    ASSERT_EQ(list.head()->prev, nullptr);
+    ASSERT_EQ(list.head()->next, nullptr);
+}
+
+// Counts the live instances, and has no default constructor
+struct Counted {
+    static inline int live = 0;
+    int value;
+
+    explicit Counted(int value) : value(value) { ++live; }
+    Counted(const Counted& other) : value(other.value) { ++live; }
+    Counted& operator=(const Counted&) = default;
+    ~Counted() { --live; }
+};
+
+TEST(Bounded, Values_Destroyed) {
+    {
+        BoundedDoublyLinkedList<Counted> list(4);
+        for (int i = 0; i < 6; i++) {
+            list.push_tail(Counted(i));
+            ASSERT_EQ(Counted::live, static_cast<int>(list.length()));
+        }
+        list.push_head(Counted(-1));
+        ASSERT_EQ(list.head()->value.value, -1);
+        ASSERT_EQ(list.tail()->value.value, 4);
+        ASSERT_EQ(Counted::live, 4);
+
+        BoundedDoublyLinkedList<Counted> moved(std::move(list));
+        ASSERT_EQ(moved.at(1)->value.value, 2);
+        moved.clear();
+        ASSERT_EQ(Counted::live, 0);
+        moved.push_tail(Counted(7));
+    }
+    ASSERT_EQ(Counted::live, 0);
+
+    // Popped and cleared values let go of what they hold
+    auto resource = std::make_shared<int>(1);
+    BoundedDoublyLinkedList<std::shared_ptr<int>> list(3);
+    list.push_tail(resource);
+    list.push_tail(resource);
+    ASSERT_EQ(resource.use_count(), 3);
+    list.pop_tail();
+    ASSERT_EQ(resource.use_count(), 2);
+    list.clear();
+    ASSERT_EQ(resource.use_count(), 1);
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+#include "../CompressedDoublyLinkedList.hh"
+
+TEST(Compressed, Push_Pop) {
+    CompressedDoublyLinkedList<int> list(4, {3, 1, 4, 1, 5, 9, 2, 6, 5, 3});
+
+    ASSERT_EQ(list.length(), 10u);
+    ASSERT_EQ(std::vector<int>(list.begin(), list.end()), std::vector<int>({3, 1, 4, 1, 5, 9, 2, 6, 5, 3}));
+
+    std::stringstream ss;
+    ss << CompressedDoublyLinkedList<int>(2, {1, 2, 3});
+    ASSERT_EQ(ss.str(), "head -> 1 <-> 2 <-> 3 <- tail");
+
+    // Unseals the blocks
+    for (int expected : {3, 5, 6, 2, 9, 5, 1, 4, 1, 3}) {
+        ASSERT_EQ(list.pop_tail(), expected);
+    }
+    ASSERT_TRUE(list.empty());
+    ASSERT_EQ(list.pop_tail(), 0);
+}
+
+TEST(Compressed, At_Set) {
+    CompressedDoublyLinkedList<int64_t> list(8);
+    std::vector<int64_t> vec;
+    for (int64_t i = 0; i < 100; ++i) {
+        vec.push_back(i * i - 50 * i);
+        list.push_tail(vec.back());
+    }
+
+    for (uint64_t pos : {99u, 0u, 57u, 56u, 63u, 96u, 1u}) {
+        ASSERT_EQ(list.at(pos), vec[pos]);
+    }
+    ASSERT_THROW(static_cast<void>(list.at(100)), std::out_of_range);
+
+    // Widens and narrows a block, writes the raw segment
+    for (uint64_t pos : {13u, 42u, 98u}) {
+        list.set(pos, std::numeric_limits<int64_t>::min());
+        vec[pos] = std::numeric_limits<int64_t>::min();
+    }
+    ASSERT_EQ(std::vector<int64_t>(list.begin(), list.end()), vec);
+    list.set(13, vec[13] = 13);
+    ASSERT_EQ(list.at(13), 13);
+    ASSERT_EQ(std::vector<int64_t>(list.begin(), list.end()), vec);
+    ASSERT_THROW(list.set(100, 0), std::out_of_range);
+}
+
+TEST(Compressed, Insert_Pop) {
+    CompressedDoublyLinkedList<int> list(4, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+    std::vector<int> vec(list.begin(), list.end());
+
+    // Grows the first block to 8 values, which splits it
+    for (int i = 0; i < 4; ++i) {
+        list.insert(2, -i);
+        vec.insert(vec.begin() + 2, -i);
+        ASSERT_EQ(std::vector<int>(list.begin(), list.end()), vec);
+    }
+    list.push_head(-9);
+    vec.insert(vec.begin(), -9);
+    ASSERT_EQ(list.at(14), 9);
+    ASSERT_THROW(list.insert(16, 0), std::out_of_range);
+
+    // Empties a block in the middle, the raw segment and the blocks around it are left
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(list.pop(5), vec[5]);
+        vec.erase(vec.begin() + 5);
+    }
+    ASSERT_EQ(std::vector<int>(list.begin(), list.end()), vec);
+    ASSERT_EQ(list.pop_head(), -9);
+    vec.erase(vec.begin());
+    ASSERT_EQ(list.pop(list.length() - 1), 9);
+    vec.pop_back();
+    ASSERT_EQ(std::vector<int>(list.begin(), list.end()), vec);
+    ASSERT_THROW(static_cast<void>(list.pop(list.length())), std::out_of_range);
+    for (int value : vec) {
+        ASSERT_EQ(list.pop_head(), value);
+    }
+    ASSERT_TRUE(list.empty());
+    ASSERT_EQ(list.pop_head(), 0);
+}
+
+TEST(Compressed, Memory_) {
+    CompressedDoublyLinkedList<uint64_t> steady(64), jittery(64);
+    std::mt19937_64 random(7);
+    const uint64_t start = 1700000000000000;
+    for (uint64_t i = 0, time = start; i < 1 << 16; ++i) {
+        steady.push_tail(start + 1000 * i);
+        jittery.push_tail(time += 1000 + random() % 256);
+    }
+
+    // Against 24 bytes per node: no packed bits at a steady rate, 8 bits per delta with jitter
+    ASSERT_LT(steady.memory_usage(), (1u << 16) * 2);
+    ASSERT_LT(jittery.memory_usage(), (1u << 16) * 3);
+    ASSERT_EQ(steady.at(12345), 1700000000000000 + 1000 * 12345);
+}
+
+// Blocks packed at every width, unpacked four deltas at a time and the rest one by one
+template <typename T>
+void
+compressed_widths(void) {
+    using U = std::make_unsigned_t<T>;
+    std::mt19937_64 random(sizeof(T));
+    for (unsigned width = 1; width <= 8 * sizeof(T); ++width) {
+        U top = static_cast<U>(std::numeric_limits<U>::max() >> (8 * sizeof(T) - width));
+        for (unsigned size : {13u, 14u}) {
+            CompressedDoublyLinkedList<T> list(size);
+            std::vector<T> vec;
+            U value = static_cast<U>(random());
+            for (unsigned i = 0; i < 3 * size; ++i) {
+                // The smallest delta 0 and the largest top in every block fix its width
+                U delta = i % size == 1 ? U(0) : i % size == 2 ? top : static_cast<U>(random() & top);
+                value = static_cast<U>(value + delta);
+                list.push_tail(static_cast<T>(value));
+                vec.push_back(static_cast<T>(value));
+            }
+            ASSERT_EQ(std::vector<T>(list.begin(), list.end()), vec) << "width " << width;
+        }
+    }
+}
+
+TEST(Compressed, Widths) {
+    compressed_widths<uint8_t>();
+    compressed_widths<int16_t>();
+    compressed_widths<uint32_t>();
+    compressed_widths<int64_t>();
+}
+
+template <typename T>
+void
+compressed_random(unsigned size, uint64_t seed) {
+    CompressedDoublyLinkedList<T> list(size);
+    std::vector<T> vec;
+    std::mt19937_64 random(seed);
+    for (int i = 0; i < 4000; i++) {
+        int op = random() % 14;
+        // Mostly small steps, sometimes anything
+        T last = vec.empty() ? T() : vec.back();
+        T value = random() % 4 ? static_cast<T>(last + random() % 5) : static_cast<T>(random());
+        if (op < 5) {
+            list.push_tail(value);
+            vec.push_back(value);
+        } else if (op < 7) {
+            ASSERT_EQ(list.pop_tail(), vec.empty() ? T() : vec.back());
+            if (not vec.empty()) {
+                vec.pop_back();
+            }
+        } else if (op < 9 and not vec.empty()) {
+            uint64_t pos = random() % vec.size();
+            list.set(pos, value);
+            vec[pos] = value;
+        } else if (op == 9 and not vec.empty()) {
+            uint64_t pos = random() % vec.size();
+            ASSERT_EQ(list.at(pos), vec[pos]);
+        } else if (op == 10) {
+            uint64_t pos = random() % (vec.size() + 1);
+            list.insert(pos, value);
+            vec.insert(vec.begin() + pos, value);
+        } else if (op == 11 and not vec.empty()) {
+            uint64_t pos = random() % vec.size();
+            ASSERT_EQ(list.pop(pos), vec[pos]);
+            vec.erase(vec.begin() + pos);
+        } else if (op == 12) {
+            list.push_head(value);
+            vec.insert(vec.begin(), value);
+        } else if (op == 13) {
+            ASSERT_EQ(list.pop_head(), vec.empty() ? T() : vec.front());
+            if (not vec.empty()) {
+                vec.erase(vec.begin());
+            }
+        }
+        ASSERT_EQ(list.length(), vec.size());
+    }
+    ASSERT_EQ(std::vector<T>(list.begin(), list.end()), vec);
+    std::vector<T> visited;
+    list.for_each([&](T value) { visited.push_back(value); });
+    ASSERT_EQ(visited, vec);
+    CompressedDoublyLinkedList<T> copy = list;
+    ASSERT_EQ(copy, list);
+}
+
+TEST(Compressed, Random) {
+    for (unsigned size : {1u, 3u, 16u, 64u}) {
+        compressed_random<int8_t>(size, size);
+        compressed_random<uint16_t>(size, size + 1);
+        compressed_random<int32_t>(size, size + 2);
+        compressed_random<uint64_t>(size, size + 3);
+        compressed_random<int64_t>(size, size + 4);
+    }
+}
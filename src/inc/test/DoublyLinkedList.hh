@@ -1,8 +1,28 @@
 #pragma once
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "../DoublyLinkedList.hh"
 
 const unsigned SIZE = 8;
+// Whether the lists count, the tests also run against a build without the counters
+#ifdef DOUBLY_LINKED_LIST_STATS
+const bool STATS = true;
+#else
+const bool STATS = false;
+#endif
 const std::string OUT_FILE = "out.txt";
 const std::string IN_FILE = OUT_FILE;
 
@@ -123,6 +143,84 @@ TEST(Property, InFile_) {
     ASSERT_EQ(list1, list2);
 }
 
+TEST(Property, Ingest_) {
+    DoublyLinkedList<int> list(3, {-2, -1});
+    list.from_string = [](const std::string& line) -> int { return std::stoi(line); };
+    std::istringstream input("0\n1\n2\n3\n4\n5\n6");
+
+    std::future<uint64_t> done = list.ingest(input, 2);
+    ASSERT_EQ(done.get(), 7u);
+    ASSERT_EQ(list, DoublyLinkedList<int>(3, {-2, -1, 0, 1, 2, 3, 4, 5, 6}));
+    for (int i = 0; i < 9; ++i) {
+        ASSERT_EQ(list.at(i)->value, i - 2);
+    }
+
+    // Appended at the head in storage order
+    list.reverse();
+    std::istringstream more("7\n8\n");
+    ASSERT_EQ(list.ingest(more).get(), 2u);
+    ASSERT_EQ(list, DoublyLinkedList<int>(3, {6, 5, 4, 3, 2, 1, 0, -1, -2, 7, 8}));
+}
+
+TEST(Property, Ingest_Large) {
+    DoublyLinkedList<uint64_t> list(64);
+    list.from_string = [](const std::string& line) -> uint64_t { return std::stoull(line); };
+    std::string text;
+    const uint64_t n = 500000;
+    for (uint64_t i = 0; i < n; ++i) {
+        text += std::to_string(i * 3) + "\n";
+    }
+    ASSERT_GT(text.size(), 2 * list.ingest_block);
+    std::istringstream input(text);
+
+    ASSERT_EQ(list.ingest(input, 4).get(), n);
+    ASSERT_EQ(list.length(), n);
+    uint64_t expected = 0;
+    for (uint64_t value : list) {
+        ASSERT_EQ(value, expected);
+        expected += 3;
+    }
+    for (uint64_t pos : {0ul, 63ul, 64ul, 12345ul, n - 2, n - 1}) {
+        ASSERT_EQ(list.at(pos)->value, pos * 3);
+    }
+    ASSERT_EQ(list.tail()->next, nullptr);
+}
+
+TEST(Property, Ingest_Fd) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    DoublyLinkedList<std::string> list(4);
+    list.from_string = [](const std::string& line) -> std::string { return line; };
+
+    std::future<uint64_t> done = list.ingest(fds[0]);
+    std::thread writer([fd = fds[1]]() -> void {
+        std::string text = "one\ntwo\n\nfour";
+        ASSERT_EQ(write(fd, text.data(), text.size()), static_cast<ssize_t>(text.size()));
+        close(fd);
+    });
+    ASSERT_EQ(done.get(), 4u);
+    writer.join();
+    close(fds[0]);
+    ASSERT_EQ(list, DoublyLinkedList<std::string>(4, {"one", "two", "", "four"}));
+}
+
+TEST(Property, Ingest_Error) {
+    DoublyLinkedList<int> list(8);
+    list.from_string = [](const std::string& line) -> int { return std::stoi(line); };
+    std::string text;
+    for (int i = 0; i < 300000; ++i) {
+        text += i == 250000 ? "x\n" : std::to_string(i) + "\n";
+    }
+    std::istringstream input(text);
+
+    ASSERT_THROW(list.ingest(input, 3).get(), std::invalid_argument);
+    // Whatever was spliced is a prefix
+    ASSERT_LT(list.length(), 250000u);
+    for (uint64_t pos = 0; pos < list.length(); pos += 997) {
+        ASSERT_EQ(list.at(pos)->value, static_cast<int>(pos));
+    }
+}
+
 TEST(Method, Clear_) {
     DoublyLinkedList<int> list1(SIZE, {1, 2, 3});
     DoublyLinkedList<int> list2(SIZE);
@@ -391,3 +489,1109 @@ TEST(Method, Sort_Descending) {
     ASSERT_EQ(list1.at(7)->value, 2);
     ASSERT_EQ(list1.at(8)->value, 1);
 }
+
+TEST(Method, ForEach_Parallel) {
+    DoublyLinkedList<int> list1(3, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    DoublyLinkedList<int> list2(3, {2, 4, 6, 8, 10, 12, 14, 16, 18, 20});
+
+    list1.for_each(list1.par, [](int& value) -> void { value *= 2; });
+
+    ASSERT_EQ(list1, list2);
+}
+
+TEST(Method, Reduce_) {
+    std::vector<uint64_t> vec(1000);
+    std::iota(vec.begin(), vec.end(), 1);
+    DoublyLinkedList<uint64_t> list(7, vec.begin(), vec.end());
+
+    ASSERT_EQ(list.reduce(list.seq, uint64_t(0), std::plus<>()), 500500);
+    ASSERT_EQ(list.reduce(DoublyLinkedList<uint64_t>::Parallel{4}, uint64_t(10), std::plus<>()), 500510);
+    ASSERT_EQ(DoublyLinkedList<int>(SIZE).reduce(DoublyLinkedList<int>::par, 42, std::plus<>()), 42);
+}
+
+TEST(Method, TransformInplace_) {
+    DoublyLinkedList<int> list1(2, {1, 2, 3, 4, 5});
+    DoublyLinkedList<int> list2(2, {1, 4, 9, 16, 25});
+
+    list1.transform_inplace(DoublyLinkedList<int>::Parallel{3}, [](int value) -> int { return value * value; });
+
+    ASSERT_EQ(list1, list2);
+}
+
+TEST(Method, CountIf_) {
+    DoublyLinkedList<int> list(3, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    auto even = [](int value) -> bool { return value % 2 == 0; };
+
+    ASSERT_EQ(list.count_if(list.seq, even), 5);
+    ASSERT_EQ(list.count_if(DoublyLinkedList<int>::Parallel{8}, even), 5);
+}
+
+TEST(Method, Find_Count) {
+    std::vector<int> vec(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+    // Contiguous after bulk construction
+    DoublyLinkedList<int> list(16, vec.begin(), vec.end());
+    list.push_tail(500);
+
+    ASSERT_EQ(list.find(500), list.at(500));
+    ASSERT_EQ(list.find(1000), nullptr);
+    ASSERT_EQ(list.count(500), 2u);
+    ASSERT_EQ(list.count(-1), 0u);
+
+    list.reverse();
+    ASSERT_EQ(list.find(500), list.head());
+    ASSERT_EQ(list.find(999), list.at(1));
+
+    DoublyLinkedList<std::string> strings(2, {"a", "b", "a"});
+    ASSERT_EQ(strings.find("b"), strings.at(1));
+    ASSERT_EQ(strings.count("a"), 2u);
+}
+
+// find and count over contiguous lists of T, across the 32 nodes the AVX2 kernels take at once
+template <typename T>
+void
+find_lanes(void) {
+    for (uint64_t length : {1u, 31u, 32u, 33u, 96u, 250u}) {
+        std::vector<T> vec(length);
+        for (uint64_t i = 0; i < length; ++i) {
+            vec[i] = static_cast<T>(i % 7 + (i == length - 1 ? 2 : 0));
+        }
+        DoublyLinkedList<T> list(8, vec.begin(), vec.end());
+        // Then from the tail, which the kernels scan backwards
+        for (int pass = 0; pass < 2; ++pass) {
+            for (T value : {T(0), T(3), T(6), T(8), T(9)}) {
+                auto it = std::find(vec.begin(), vec.end(), value);
+                ASSERT_EQ(list.find(value), it == vec.end() ? nullptr : list.at(it - vec.begin()));
+                ASSERT_EQ(list.count(value), static_cast<uint64_t>(std::count(vec.begin(), vec.end(), value)));
+            }
+            list.reverse();
+            std::reverse(vec.begin(), vec.end());
+        }
+    }
+}
+
+TEST(Method, Find_Lanes) {
+    find_lanes<int8_t>();
+    find_lanes<uint16_t>();
+    find_lanes<int32_t>();
+    find_lanes<uint64_t>();
+    find_lanes<float>();
+    find_lanes<double>();
+
+    // Compared as T, not bitwise
+    std::vector<double> vec(40, 1.0);
+    vec[35] = -0.0;
+    vec[36] = std::numeric_limits<double>::quiet_NaN();
+    DoublyLinkedList<double> list(8, vec.begin(), vec.end());
+    ASSERT_EQ(list.find(0.0), list.at(35));
+    ASSERT_EQ(list.count(std::numeric_limits<double>::quiet_NaN()), 0u);
+}
+
+// Values pushed into the room compact(spare) left keep the layout contiguous, later ones are found by walking
+TEST(Method, Find_Appended) {
+    std::vector<int> vec(100);
+    std::iota(vec.begin(), vec.end(), 0);
+    DoublyLinkedList<int> list(4, vec.begin(), vec.end());
+    list.compact(50);
+    for (int i = 100; i < 150; ++i) {
+        list.push_tail(i);
+    }
+
+    ASSERT_EQ(list.at(149), list.head() + 149);
+    ASSERT_EQ(list.find(149), list.at(149));
+    ASSERT_EQ(list.count(120), 1u);
+    list.push_tail(150);
+    ASSERT_EQ(list.find(150), list.at(150));
+    list.pop_tail();
+    list.pop_head();
+    list.push_tail(150);
+    ASSERT_EQ(list.find(150), list.at(149));
+    ASSERT_EQ(list.find(0), nullptr);
+}
+
+TEST(Method, MinMaxSum) {
+    DoublyLinkedList<double> list(4, {2.5, -1.0, 8.0, 0.5, 3.0});
+
+    ASSERT_EQ(list.min(), -1.0);
+    ASSERT_EQ(list.max(), 8.0);
+    ASSERT_EQ(list.sum(), 13.0);
+
+    list.push_head(-7.0);
+    list.compact();
+    ASSERT_EQ(list.min(), -7.0);
+    ASSERT_EQ(list.sum(), 6.0);
+
+    DoublyLinkedList<uint8_t> bytes(3, {200, 100, 7});
+    ASSERT_EQ(bytes.sum(), 51);
+    ASSERT_EQ(DoublyLinkedList<int>(3).min(), 0);
+}
+
+TEST(Method, Search_Random) {
+    DoublyLinkedList<int64_t> list(5);
+    std::deque<int64_t> model;
+    std::mt19937 random(9);
+
+    for (int i = 0; i < 2000; ++i) {
+        size_t k = model.empty() ? 0 : random() % model.size();
+        int64_t value = static_cast<int64_t>(random() % 64) - 32;
+        int op = model.empty() ? 0 : random() % 8;
+        if (op == 0) {
+            list.push_tail(value);
+            model.push_back(value);
+        } else if (op == 1) {
+            ASSERT_EQ(list.pop_head(), model.front());
+            model.pop_front();
+        } else if (op == 2) {
+            list.insert(k, value);
+            model.insert(model.begin() + k, value);
+        } else if (op == 3) {
+            ASSERT_EQ(list.pop(k), model[k]);
+            model.erase(model.begin() + k);
+        } else if (op == 4) {
+            list.reverse();
+            std::reverse(model.begin(), model.end());
+        } else if (op == 5) {
+            list.rotate(k);
+            std::rotate(model.begin(), model.begin() + k, model.end());
+        } else {
+            list.compact();
+        }
+
+        auto it = std::find(model.begin(), model.end(), value);
+        DoublyLinkedList<int64_t>::Node* expected = it == model.end() ? nullptr : list.at(it - model.begin());
+        ASSERT_EQ(list.find(value), expected);
+        ASSERT_EQ(list.count(value), static_cast<uint64_t>(std::count(model.begin(), model.end(), value)));
+        if (not model.empty()) {
+            ASSERT_EQ(list.min(), *std::min_element(model.begin(), model.end()));
+            ASSERT_EQ(list.max(), *std::max_element(model.begin(), model.end()));
+            ASSERT_EQ(list.sum(), std::accumulate(model.begin(), model.end(), int64_t(0)));
+        }
+        DoublyLinkedList<int64_t> other(7, model.begin(), model.end());
+        ASSERT_EQ(list, other);
+        if (not model.empty()) {
+            other.at(k % model.size())->value += 1;
+            ASSERT_NE(list, other);
+        }
+    }
+}
+
+TEST(Method, ApplyBatch_) {
+    using Op = DoublyLinkedList<int>::Op;
+    DoublyLinkedList<int> list(3, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+
+    // Positions follow the earlier ops: 2 is popped before 3, the inserted 42 is popped again
+    std::vector<int> popped = list.apply_batch({{Op::pop, 2}, {Op::pop, 2}, {Op::insert, 0, -1}, {Op::insert, 5, 42},
+                                                {Op::insert, 10, 10}, {Op::pop, 5}, {Op::pop, 9}});
+    ASSERT_EQ(popped, std::vector<int>({2, 3, 42, 10}));
+    ASSERT_EQ(list, DoublyLinkedList<int>(5, {-1, 0, 1, 4, 5, 6, 7, 8, 9}));
+    ASSERT_EQ(list.at(8)->value, 9);
+
+    ASSERT_THROW(list.apply_batch({{Op::pop, 0}, {Op::insert, 9, 0}}), std::out_of_range);
+    ASSERT_EQ(list.length(), 9);
+    ASSERT_TRUE(list.apply_batch({}).empty());
+
+    list.reverse();
+    ASSERT_EQ(list.apply_batch({{Op::pop, 0}, {Op::insert, 8, 100}}), std::vector<int>({9}));
+    ASSERT_EQ(list, DoublyLinkedList<int>(2, {8, 7, 6, 5, 4, 1, 0, -1, 100}));
+
+    ASSERT_EQ(list.apply_batch({{Op::pop, 8}, {Op::pop, 0}, {Op::pop, 0}, {Op::pop, 0}, {Op::pop, 0}, {Op::pop, 0},
+                                {Op::pop, 0}, {Op::pop, 0}, {Op::pop, 0}}),
+              std::vector<int>({100, 8, 7, 6, 5, 4, 1, 0, -1}));
+    ASSERT_TRUE(list.empty());
+    list.apply_batch({{Op::insert, 0, 1}, {Op::insert, 0, 0}});
+    ASSERT_EQ(list, DoublyLinkedList<int>(1, {0, 1}));
+}
+
+TEST(Method, ApplyBatch_Random) {
+    using Op = DoublyLinkedList<int64_t>::Op;
+    std::mt19937 random(11);
+
+    for (unsigned size : {1u, 2u, 5u, 16u}) {
+        DoublyLinkedList<int64_t> list(size);
+        std::deque<int64_t> model;
+        for (int round = 0; round < 50; ++round) {
+            std::vector<Op> ops;
+            std::vector<int64_t> expected;
+            for (uint64_t i = 0, n = random() % 40, length = model.size(); i < n; ++i) {
+                int64_t value = static_cast<int64_t>(random());
+                if (length == 0 or random() % 2) {
+                    uint64_t pos = random() % (length + 1);
+                    ops.push_back({Op::insert, pos, value});
+                    model.insert(model.begin() + pos, value);
+                    ++length;
+                } else {
+                    uint64_t pos = random() % length;
+                    ops.push_back({Op::pop, pos});
+                    expected.push_back(model[pos]);
+                    model.erase(model.begin() + pos);
+                    --length;
+                }
+            }
+            if (round % 10 == 0) {
+                list.reverse();
+                list.reverse();
+            }
+#ifdef __cpp_lib_span
+            ASSERT_EQ(round % 2 ? list.apply_batch(ops) : list.apply_batch(ops.begin(), ops.end()), expected);
+#else
+            ASSERT_EQ(list.apply_batch(ops.begin(), ops.end()), expected);
+#endif
+            ASSERT_EQ(list.length(), model.size());
+            ASSERT_EQ(list, DoublyLinkedList<int64_t>(size, model.begin(), model.end()));
+            for (uint64_t pos = 0; pos < model.size(); pos += 7) {
+                ASSERT_EQ(list.at(pos)->value, model[pos]);
+            }
+        }
+    }
+}
+
+TEST(Method, Fingerprint_Diff) {
+    using Ranges = std::vector<std::pair<uint64_t, uint64_t>>;
+    std::vector<int> vec(20);
+    std::iota(vec.begin(), vec.end(), 0);
+    DoublyLinkedList<int> list(4, vec.begin(), vec.end()), replica(4, vec.begin(), vec.end());
+    list.fingerprint(true);
+    replica.fingerprint(true);
+    ASSERT_TRUE(list.fingerprinted());
+    ASSERT_TRUE(list.diff(replica).empty());
+
+    // Shifts every segment from the fourth on, which is all that has to be shipped
+    list.insert(13, -1);
+    list.pop(14);
+    ASSERT_EQ(list.diff(replica), Ranges({{12, 16}}));
+    ASSERT_NE(list, replica);
+    replica.insert(13, -1);
+    replica.pop(14);
+    ASSERT_EQ(list, replica);
+
+    list.push_tail(20);
+    ASSERT_EQ(list.diff(replica), Ranges({{20, 21}}));
+    list.pop_head();
+    ASSERT_EQ(list.diff(replica), Ranges({{0, 20}}));
+    list.push_head(0);
+    list.pop_tail();
+    ASSERT_TRUE(list.diff(replica).empty());
+
+    // Writes through a node are only seen once the fingerprints are recomputed
+    list.at(5)->value = 50;
+    list.fingerprint(true);
+    ASSERT_EQ(list.diff(replica), Ranges({{4, 8}}));
+    // operator== compares the values, and so sees them
+    list.at(5)->value = 5;
+    ASSERT_EQ(list, replica);
+    list.at(5)->value = 50;
+    ASSERT_NE(list, replica);
+
+    // Without fingerprints on both sides the values are compared
+    replica.fingerprint(false);
+    ASSERT_EQ(list.diff(replica), Ranges({{4, 8}}));
+    ASSERT_EQ(replica.diff(DoublyLinkedList<int>(4, {0, 1, 2, 3, 4})), Ranges({{4, 20}}));
+}
+
+TEST(Method, Fingerprint_Random) {
+    std::mt19937 random(17);
+
+    for (unsigned size : {1u, 3u, 8u}) {
+        DoublyLinkedList<int64_t> list(size);
+        list.fingerprint(true);
+        std::deque<int64_t> model;
+        for (int i = 0; i < 3000; ++i) {
+            uint64_t k = model.empty() ? 0 : random() % model.size();
+            int64_t value = static_cast<int64_t>(random() % 16);
+            int op = random() % 12;
+            if (op < 2) {
+                list.push_tail(value);
+                model.push_back(value);
+            } else if (op < 4) {
+                list.push_head(value);
+                model.push_front(value);
+            } else if (op < 6) {
+                k = model.empty() ? 0 : random() % (model.size() + 1);
+                list.insert(k, value);
+                model.insert(model.begin() + k, value);
+            } else if (op < 8 and not model.empty()) {
+                ASSERT_EQ(list.pop(k), model[k]);
+                model.erase(model.begin() + k);
+            } else if (op == 8 and not model.empty()) {
+                ASSERT_EQ(list.pop_head(), model.front());
+                model.pop_front();
+            } else if (op == 9 and not model.empty()) {
+                ASSERT_EQ(list.pop_tail(), model.back());
+                model.pop_back();
+            } else if (op == 10 and random() % 8 == 0) {
+                list.reverse();
+                std::reverse(model.begin(), model.end());
+            } else if (op == 11 and not model.empty() and random() % 8 == 0) {
+                list.erase(list.at(k));
+                model.erase(model.begin() + k);
+            }
+
+            // Fingerprints built from scratch against the ones kept along, in the same storage order
+            DoublyLinkedList<int64_t> fresh = list.reversed()
+                                                  ? DoublyLinkedList<int64_t>(size, model.rbegin(), model.rend())
+                                                  : DoublyLinkedList<int64_t>(size, model.begin(), model.end());
+            if (list.reversed()) {
+                fresh.reverse();
+            }
+            fresh.fingerprint(true);
+            ASSERT_TRUE(list.diff(fresh).empty()) << i;
+        }
+    }
+}
+
+TEST(Method, Segments_Slice) {
+    std::vector<int> vec(22);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    for (bool reversed : {false, true}) {
+        DoublyLinkedList<int> list(4, vec.begin(), vec.end());
+        std::vector<int> model = vec;
+        if (reversed) {
+            list.reverse();
+            std::reverse(model.begin(), model.end());
+        }
+        // Taking out a middle node leaves the anchors stale until segments() repairs them
+        list.erase(list.at(9));
+        model.erase(model.begin() + 9);
+
+        // Storage order cuts the segments, so the short one ends up first after reverse()
+        std::vector<std::vector<int>> segments;
+        for (const auto& segment : list.segments()) {
+            segments.emplace_back(segment.begin(), segment.end());
+            ASSERT_EQ(segments.back().size(), segment.size());
+        }
+        ASSERT_EQ(segments.size(), 6u);
+        ASSERT_EQ(segments[reversed ? 0 : 5].size(), 1u);
+        ASSERT_EQ(segments[reversed ? 5 : 0].size(), 4u);
+        std::vector<int> joined;
+        for (const std::vector<int>& segment : segments) {
+            joined.insert(joined.end(), segment.begin(), segment.end());
+        }
+        ASSERT_EQ(joined, model);
+        ASSERT_EQ(*list.segments()[2].begin(), model[reversed ? 5 : 8]);
+
+        for (uint64_t pos = 0; pos <= model.size(); ++pos) {
+            for (uint64_t len = 0; pos + len <= model.size(); ++len) {
+                auto slice = list.slice(pos, len);
+                ASSERT_EQ(std::vector<int>(slice.begin(), slice.end()),
+                          std::vector<int>(model.begin() + pos, model.begin() + pos + len));
+            }
+        }
+        ASSERT_THROW(static_cast<void>(list.slice(22, 0)), std::out_of_range);
+        ASSERT_THROW(static_cast<void>(list.slice(3, 19)), std::out_of_range);
+
+        for (int& value : list.slice(2, 3)) {
+            value = -value;
+        }
+        ASSERT_EQ(list.at(3)->value, -model[3]);
+    }
+
+    DoublyLinkedList<int> empty(4);
+    ASSERT_TRUE(empty.segments().empty());
+    ASSERT_TRUE(empty.slice(0, 0).empty());
+}
+
+TEST(Method, Chunks_) {
+    std::vector<int> vec(22);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    for (bool reversed : {false, true}) {
+        DoublyLinkedList<int> list(4, vec.begin(), vec.end());
+        std::vector<int> model = vec;
+        if (reversed) {
+            list.reverse();
+            std::reverse(model.begin(), model.end());
+        }
+        // Cut from the head whatever the storage order, the short chunk is always the last one
+        for (uint64_t n : {1u, 3u, 4u, 7u, 22u, 30u}) {
+            auto chunks = list.chunks(n);
+            ASSERT_EQ(chunks.size(), (model.size() + n - 1) / n);
+            uint64_t pos = 0;
+            for (const auto& chunk : chunks) {
+                uint64_t len = std::min<uint64_t>(n, model.size() - pos);
+                ASSERT_EQ(chunk.size(), len);
+                ASSERT_EQ(std::vector<int>(chunk.begin(), chunk.end()),
+                          std::vector<int>(model.begin() + pos, model.begin() + pos + len));
+                pos += len;
+            }
+            ASSERT_EQ(pos, model.size());
+            ASSERT_EQ(*chunks[chunks.size() - 1].begin(), model[(chunks.size() - 1) * n]);
+        }
+    }
+
+    ASSERT_THROW(static_cast<void>(DoublyLinkedList<int>(4, {1}).chunks(0)), std::invalid_argument);
+    DoublyLinkedList<int> empty(4);
+    ASSERT_TRUE(empty.chunks(3).empty());
+    ASSERT_EQ(empty.chunks(3).begin(), empty.chunks(3).end());
+}
+
+#ifdef __cpp_lib_ranges
+TEST(Method, Segments_Ranges) {
+    static_assert(std::bidirectional_iterator<DoublyLinkedList<int>::ConstReverseIterator>);
+    static_assert(std::ranges::view<DoublyLinkedList<int>::Slice>);
+    static_assert(std::ranges::bidirectional_range<DoublyLinkedList<int>::Segments>);
+    static_assert(std::ranges::forward_range<DoublyLinkedList<int>::Chunks>);
+
+    std::vector<int> vec(50);
+    std::iota(vec.begin(), vec.end(), 0);
+    DoublyLinkedList<int> list(SIZE, vec.begin(), vec.end());
+
+    ASSERT_TRUE(std::ranges::equal(list.segments() | std::views::join, vec));
+    ASSERT_TRUE(std::ranges::equal(list.chunks(6) | std::views::join, vec));
+    ASSERT_EQ(*std::ranges::find(list.slice(20, 10), 25), 25);
+    auto thirds = list.slice(20, 10) | std::views::filter([](int value) { return value % 3 == 0; });
+    ASSERT_EQ(std::ranges::distance(thirds), 3);
+
+    // One sum per segment, as a job per segment would compute them
+    std::vector<int> sums;
+    std::ranges::transform(list.segments(), std::back_inserter(sums),
+                           [](const auto& segment) { return std::accumulate(segment.begin(), segment.end(), 0); });
+    ASSERT_EQ(sums.size(), 7u);
+    ASSERT_EQ(sums.front(), 28);
+    ASSERT_EQ(sums.back(), 48 + 49);
+    ASSERT_EQ(std::accumulate(sums.begin(), sums.end(), 0), 49 * 50 / 2);
+}
+#endif
+
+TEST(Property, Constructor_Bulk) {
+    std::vector<uint64_t> vec(200003);
+    std::iota(vec.begin(), vec.end(), 0);
+    DoublyLinkedList<uint64_t> list(1000, vec.begin(), vec.end());
+
+    ASSERT_EQ(list.length(), vec.size());
+    ASSERT_EQ(list.head()->prev, nullptr);
+    ASSERT_EQ(list.tail()->next, nullptr);
+    ASSERT_EQ(list.tail()->value, 200002);
+    for (uint64_t pos = 0; pos < vec.size(); pos += 997) {
+        ASSERT_EQ(list.at(pos)->value, pos);
+    }
+    ASSERT_EQ(list.at(200000)->value, 200000);
+
+    list.push_tail(200003);
+    list.pop(5);
+    list.push_head(7);
+    ASSERT_EQ(list.at(200002)->value, 200002);
+    ASSERT_EQ(list.at(200003)->value, 200003);
+    ASSERT_EQ(list.at(6)->value, 6);
+}
+
+TEST(Property, Constructor_Copy) {
+    DoublyLinkedList<int> list1(3, {1, 2, 3, 4, 5});
+    DoublyLinkedList<int> list2(list1);
+
+    list1.pop_head();
+
+    ASSERT_EQ(list2.length(), 5);
+    ASSERT_EQ(list2.at(4)->value, 5);
+    ASSERT_NE(list1, list2);
+}
+
+TEST(Method, Compact_) {
+    DoublyLinkedList<int> list1(3);
+    DoublyLinkedList<int> list2(3, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    for (int value = 10; value > 0; --value) {
+        list1.push_head(value);
+    }
+    list1.insert(4, 0);
+    list1.pop(4);
+
+    list1.compact();
+
+    ASSERT_EQ(list1, list2);
+    for (uint64_t pos = 0; pos < list1.length(); ++pos) {
+        ASSERT_EQ(list1.at(pos), list1.head() + pos);
+        ASSERT_EQ(list1.at(pos)->value, pos + 1);
+    }
+    list1.push_tail(11);
+    list1.push_head(0);
+    ASSERT_EQ(list1.at(11)->value, 11);
+    ASSERT_EQ(list1.at(0)->value, 0);
+}
+
+TEST(Method, Compact_Segments) {
+    DoublyLinkedList<int> list1(3, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    DoublyLinkedList<int> list2(3, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+
+    ASSERT_EQ(list1.compact(0, 0), 0);
+    ASSERT_EQ(list1.compact(3, 0), 3);
+    ASSERT_EQ(list1, list2);
+
+    ASSERT_EQ(list1.compact(1, 1), 2);
+    ASSERT_EQ(list1, list2);
+    ASSERT_EQ(list1.at(4), list1.at(3) + 1);
+    ASSERT_EQ(list1.at(5), list1.at(3) + 2);
+
+    ASSERT_EQ(list1.compact(2, 10), 4);
+    ASSERT_EQ(list1, list2);
+    ASSERT_EQ(list1.tail(), list1.at(6) + 3);
+    ASSERT_EQ(list1.tail()->value, 10);
+    ASSERT_THROW(list1.compact(4, 1), std::out_of_range);
+
+    list1.push_tail(11);
+    ASSERT_EQ(list1.pop(6), 7);
+    ASSERT_EQ(list1.at(9)->value, 11);
+}
+
+TEST(Method, Stats_) {
+    using Stats = DoublyLinkedList<int>::Stats;
+    DoublyLinkedList<int> list(3, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    list.reset_stats();
+
+    ASSERT_EQ(list.at(5)->value, 6);
+    list.push_head(0);
+    list.pop(4);
+    list.sort(true);
+
+    Stats stats = list.stats();
+    ASSERT_EQ(stats.hops, STATS ? 2 + 1 : 0);
+    ASSERT_EQ(stats.shifted, STATS ? 3 + 2 : 0);
+    ASSERT_EQ(stats.allocations, STATS ? 1 : 0);
+    ASSERT_EQ(stats.frees, STATS ? 1 : 0);
+    ASSERT_EQ(stats.comparisons > 0, STATS);
+    ASSERT_EQ(std::accumulate(stats.latency[Stats::at].begin(), stats.latency[Stats::at].end(), uint64_t(0)),
+              STATS ? 2 : 0);
+    ASSERT_EQ(std::accumulate(stats.latency[Stats::sort].begin(), stats.latency[Stats::sort].end(), uint64_t(0)),
+              STATS ? 1 : 0);
+
+    list.reset_stats();
+    ASSERT_EQ(list.stats().hops, 0);
+}
+
+TEST(Method, Stats_Concurrent) {
+    using Stats = DoublyLinkedList<int>::Stats;
+    std::vector<int> vec(1000);
+    DoublyLinkedList<int> list(10, vec.begin(), vec.end());
+    list.reset_stats();
+
+    // Const readers count into the same list at once
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&list, t]() -> void {
+            for (uint64_t i = 0; i < 10000; ++i) {
+                static_cast<void>(list.at((i * 7 + t) % 1000));
+                static_cast<void>(list.stats());
+            }
+        });
+    }
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    Stats stats = list.stats();
+    ASSERT_EQ(std::accumulate(stats.latency[Stats::at].begin(), stats.latency[Stats::at].end(), uint64_t(0)),
+              STATS ? 40000 : 0);
+}
+
+TEST(Method, MemoryUsage_) {
+    using Node = DoublyLinkedList<int>::Node;
+    std::vector<int> vec(1000);
+    DoublyLinkedList<int> list(10, vec.begin(), vec.end());
+
+    auto usage = list.memory_usage();
+    ASSERT_EQ(usage.nodes, 1000 * sizeof(Node));
+    ASSERT_EQ(usage.index, 101 * sizeof(Node*));
+
+    for (int i = 0; i < 990; ++i) {
+        list.pop_tail();
+    }
+    usage = list.memory_usage();
+    ASSERT_EQ(usage.nodes, 10 * sizeof(Node));
+    ASSERT_EQ(usage.index, 2 * sizeof(Node*));
+    ASSERT_GE(usage.slack, 990 * sizeof(Node));
+
+    list.shrink_to_fit();
+    usage = list.memory_usage();
+    ASSERT_LT(usage.slack, 990 * sizeof(Node));
+    ASSERT_EQ(list.length(), 10);
+    ASSERT_EQ(list.at(9), list.head() + 9);
+}
+
+TEST(Method, MemoryUsage_Trim) {
+    using Node = DoublyLinkedList<int>::Node;
+    DoublyLinkedList<int> list(16);
+    for (int i = 0; i < 200000; ++i) {
+        list.push_tail(i);
+    }
+    std::vector<Node*> kept;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        kept.push_back(list.at(i));
+    }
+
+    // Mostly from the tail, now and then from the middle behind the nodes that are kept
+    std::mt19937 random(3);
+    while (list.length() > 1000) {
+        uint64_t pos = random() % 16 ? list.length() - 1 : 1000 + random() % (list.length() - 1000);
+        ASSERT_GE(list.pop(pos), 1000);
+    }
+
+    // Blocks emptied on the way were given back except the last one, the nodes left did not move
+    ASSERT_LT(list.memory_usage().slack, 70000 * sizeof(Node));
+    for (uint64_t i = 0; i < 1000; ++i) {
+        ASSERT_EQ(list.at(i), kept[i]);
+        ASSERT_EQ(list.at(i)->value, static_cast<int>(i));
+    }
+    for (int i = 0; i < 100000; ++i) {
+        list.push_tail(i);
+    }
+    ASSERT_EQ(list.at(100999)->value, 99999);
+}
+
+TEST(Method, Pop_Trim) {
+    // Many small blocks, so that popping below a quarter of the peak gives some back
+    DoublyLinkedList<int> list(4);
+    for (int i = 0; i < 400; ++i) {
+        list.push_tail(i);
+    }
+    for (uint64_t first = 0; first < 100; ++first) {
+        list.compact(first, 1);
+    }
+    for (int i = 0; i < 297; ++i) {
+        list.pop_tail();
+    }
+
+    // Positions 40 to 43 hold an anchor each time
+    for (int i = 43; i >= 40; --i) {
+        ASSERT_EQ(list.pop(i), i);
+        ASSERT_EQ(list.length(), static_cast<uint64_t>(i + 59));
+    }
+    for (uint64_t i = 0; i < list.length(); ++i) {
+        ASSERT_EQ(list.at(i)->value, static_cast<int>(i < 40 ? i : i + 4));
+    }
+}
+
+TEST(Method, Reserve_) {
+    DoublyLinkedList<int> list(4, {1, 2});
+    list.reserve(1000);
+    list.reset_stats();
+
+    for (int i = 0; i < 998; ++i) {
+        list.push_tail(i);
+    }
+
+    ASSERT_EQ(list.stats().blocks, 0);
+    ASSERT_EQ(list.stats().reallocations, 0);
+    ASSERT_EQ(list.at(999)->value, 997);
+    ASSERT_EQ(list.memory_usage().nodes, 1000 * sizeof(DoublyLinkedList<int>::Node));
+}
+
+TEST(Method, Resize_Short) {
+    DoublyLinkedList<int> list1(3);
+    DoublyLinkedList<int> list2(3, {0, 1});
+
+    list1.resize(2);
+    list1.push_tail(1);
+    list1.resize(5);
+    list1.push_head(0);
+
+    ASSERT_EQ(list1, list2);
+    ASSERT_EQ(list1.at(1)->value, 1);
+}
+
+TEST(Method, Erase_Node) {
+    DoublyLinkedList<int> list(3);
+    std::vector<DoublyLinkedList<int>::Node*> nodes;
+    for (int i = 0; i < 12; ++i) {
+        nodes.push_back(list.push_tail(i));
+    }
+
+    ASSERT_EQ(list.erase(nodes[4]), 4);
+    ASSERT_EQ(list.erase(nodes[0]), 0);
+    ASSERT_EQ(list.erase(nodes[11]), 11);
+    // Head and tail stay usable while the anchors in between are stale
+    list.push_head(-1);
+    list.push_tail(12);
+    list.pop_head();
+    ASSERT_EQ(list.head()->value, 1);
+    ASSERT_EQ(list.tail()->value, 12);
+
+    std::vector<int> vec = {1, 2, 3, 5, 6, 7, 8, 9, 10, 12};
+    ASSERT_EQ(list.length(), vec.size());
+    for (size_t i = 0; i < vec.size(); ++i) {
+        ASSERT_EQ(list.at(i)->value, vec[i]);
+    }
+    ASSERT_EQ(list.stats().repairs, STATS ? 1 : 0);
+    ASSERT_EQ(list.pop(4), 6);
+    ASSERT_EQ(list.at(8)->value, 12);
+}
+
+TEST(Method, MoveToHead_) {
+    DoublyLinkedList<int> list1(2, {0, 1, 2, 3, 4, 5, 6});
+    DoublyLinkedList<int> list2(2, {6, 3, 0, 1, 2, 4, 5});
+
+    list1.move_to_head(list1.at(3));
+    list1.move_to_head(list1.tail());
+    list1.move_to_head(list1.head());
+
+    ASSERT_EQ(list1, list2);
+    ASSERT_EQ(list1.tail()->value, 5);
+    ASSERT_EQ(list1.tail()->next, nullptr);
+    ASSERT_EQ(list1.head()->prev, nullptr);
+    for (int i = 0; i < 7; ++i) {
+        ASSERT_EQ(list1.at(i)->value, list2.at(i)->value);
+    }
+    ASSERT_EQ(list1.reduce(DoublyLinkedList<int>::seq, 0, std::plus<>()), 21);
+}
+
+TEST(Method, InsertBefore_After) {
+    DoublyLinkedList<int> list1(2, {1, 3, 5});
+    DoublyLinkedList<int> list2(2, {0, 1, 2, 3, 4, 5, 6});
+
+    list1.insert_before(list1.head(), 0);
+    list1.insert_after(list1.tail(), 6);
+    auto* node = list1.insert_after(list1.at(1), 2);
+    list1.insert_before(node->next->next, 4);
+
+    ASSERT_EQ(list1, list2);
+    ASSERT_EQ(list1.head()->prev, nullptr);
+    ASSERT_EQ(list1.tail()->next, nullptr);
+    for (int i = 0; i < 7; ++i) {
+        ASSERT_EQ(list1.at(i)->value, i);
+    }
+}
+
+TEST(Method, MoveBefore_) {
+    DoublyLinkedList<int> list1(2, {0, 1, 2, 3, 4});
+    DoublyLinkedList<int> list2(2, {4, 1, 3, 2, 0});
+    auto* head = list1.head();
+    auto* tail = list1.tail();
+
+    list1.move_before(head, nullptr);
+    list1.move_before(tail, list1.head());
+    list1.move_before(list1.at(3), list1.at(2));
+    list1.move_before(list1.at(1), list1.at(1));
+
+    ASSERT_EQ(list1, list2);
+    ASSERT_EQ(list1.tail(), head);
+    ASSERT_EQ(list1.at(4), head);
+}
+
+// Node handle operations mixed with positional ones, checked against std::list
+TEST(Method, NodeHandles_Random) {
+    using Node = DoublyLinkedList<int>::Node;
+    DoublyLinkedList<int> list(4);
+    std::list<int> model;
+    std::vector<Node*> nodes;
+    std::mt19937 random(3);
+
+    auto index = [&nodes](Node* node) -> size_t {
+        return std::find(nodes.begin(), nodes.end(), node) - nodes.begin();
+    };
+    for (int i = 0; i < 4000; ++i) {
+        int op = nodes.empty() ? 0 : random() % 8;
+        size_t k = nodes.empty() ? 0 : random() % nodes.size();
+        if (op == 0) {
+            nodes.push_back(list.push_tail(i));
+            model.push_back(i);
+        } else if (op == 1) {
+            model.insert(std::next(model.begin(), k), i);
+            nodes.insert(nodes.begin() + k, list.insert_before(nodes[k], i));
+        } else if (op == 2) {
+            model.insert(std::next(model.begin(), k + 1), i);
+            nodes.insert(nodes.begin() + k + 1, list.insert_after(nodes[k], i));
+        } else if (op == 3) {
+            ASSERT_EQ(list.erase(nodes[k]), *std::next(model.begin(), k));
+            model.erase(std::next(model.begin(), k));
+            nodes.erase(nodes.begin() + k);
+        } else if (op == 4) {
+            size_t j = random() % (nodes.size() + 1);
+            Node* next = j == nodes.size() ? nullptr : nodes[j];
+            model.splice(std::next(model.begin(), j), model, std::next(model.begin(), k));
+            Node* node = list.move_before(nodes[k], next);
+            if (next != node) {
+                nodes.erase(nodes.begin() + k);
+                nodes.insert(next == nullptr ? nodes.end() : nodes.begin() + index(next), node);
+            }
+        } else if (op == 5) {
+            ASSERT_EQ(list.at(k), nodes[k]);
+        } else if (op == 6) {
+            ASSERT_EQ(list.pop(k), *std::next(model.begin(), k));
+            model.erase(std::next(model.begin(), k));
+            nodes.erase(nodes.begin() + k);
+        } else {
+            nodes.insert(nodes.begin(), list.push_head(i));
+            model.push_front(i);
+        }
+        ASSERT_EQ(list.length(), model.size());
+    }
+
+    ASSERT_EQ(std::vector<int>(list.begin(), list.end()), std::vector<int>(model.begin(), model.end()));
+    ASSERT_EQ(std::vector<int>(list.rbegin(), list.rend()), std::vector<int>(model.rbegin(), model.rend()));
+    for (size_t k = 0; k < nodes.size(); ++k) {
+        ASSERT_EQ(list.at(k), nodes[k]);
+    }
+}
+
+TEST(Method, Reverse_) {
+    DoublyLinkedList<int> list1(2, {0, 1, 2, 3, 4});
+    DoublyLinkedList<int> list2(2, {-1, 4, 3, 20, 2, 1, 0, 5});
+
+    list1.reverse();
+    ASSERT_EQ(list1.head()->value, 4);
+    ASSERT_EQ(list1.at(1)->value, 3);
+    list1.push_head(-1);
+    list1.push_tail(5);
+    list1.insert(3, 20);
+
+    ASSERT_EQ(list1, list2);
+    ASSERT_EQ(std::vector<int>(list1.rbegin(), list1.rend()), std::vector<int>(list2.rbegin(), list2.rend()));
+    ASSERT_EQ(list1.pop(4), 2);
+    ASSERT_EQ(list1.pop_head(), -1);
+    ASSERT_EQ(list1.pop_tail(), 5);
+
+    list1.compact();
+    ASSERT_FALSE(list1.reversed());
+    ASSERT_EQ(std::vector<int>(list1.begin(), list1.end()), std::vector<int>({4, 3, 20, 1, 0}));
+    ASSERT_EQ(list1.at(4), list1.head() + 4);
+}
+
+TEST(Method, Rotate_) {
+    DoublyLinkedList<int> list1(3, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+    DoublyLinkedList<int> list2(3, {3, 4, 5, 6, 7, 8, 9, 0, 1, 2});
+
+    list1.rotate(13);
+    ASSERT_EQ(list1, list2);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(list1.at(i)->value, (i + 3) % 10);
+    }
+
+    list1.reverse();
+    list1.rotate(1);
+    ASSERT_EQ(list1.head()->value, 1);
+    ASSERT_EQ(list1.tail()->value, 2);
+    ASSERT_EQ(list1.at(9)->value, 2);
+}
+
+// Every operation on a list that is reversed and rotated at random, checked against std::deque
+TEST(Method, ReverseRotate_Random) {
+    DoublyLinkedList<int> list(3);
+    std::deque<int> model;
+    std::mt19937 random(5);
+
+    for (int i = 0; i < 3000; ++i) {
+        size_t k = model.empty() ? 0 : random() % model.size();
+        int op = model.empty() ? random() % 2 : random() % 14;
+        if (op == 0) {
+            list.push_head(i);
+            model.push_front(i);
+        } else if (op == 1) {
+            list.push_tail(i);
+            model.push_back(i);
+        } else if (op == 2) {
+            ASSERT_EQ(list.pop_head(), model.front());
+            model.pop_front();
+        } else if (op == 3) {
+            ASSERT_EQ(list.pop_tail(), model.back());
+            model.pop_back();
+        } else if (op == 4) {
+            list.insert(k, i);
+            model.insert(model.begin() + k, i);
+        } else if (op == 5) {
+            ASSERT_EQ(list.pop(k), model[k]);
+            model.erase(model.begin() + k);
+        } else if (op == 6) {
+            list.reverse();
+            std::reverse(model.begin(), model.end());
+        } else if (op == 7) {
+            uint64_t r = random() % (2 * model.size());
+            list.rotate(r);
+            std::rotate(model.begin(), model.begin() + r % model.size(), model.end());
+        } else if (op == 8) {
+            list.insert_before(list.at(k), i);
+            model.insert(model.begin() + k, i);
+        } else if (op == 9) {
+            list.insert_after(list.at(k), i);
+            model.insert(model.begin() + k + 1, i);
+        } else if (op == 10) {
+            ASSERT_EQ(list.erase(list.at(k)), model[k]);
+            model.erase(model.begin() + k);
+        } else if (op == 11) {
+            size_t j = random() % (model.size() + 1);
+            list.move_before(list.at(k), j == model.size() ? nullptr : list.at(j));
+            int value = model[k];
+            model.insert(model.begin() + j, value);
+            model.erase(model.begin() + (j <= k ? k + 1 : k));
+        } else if (op == 12) {
+            list.move_to_head(list.at(k));
+            int value = model[k];
+            model.erase(model.begin() + k);
+            model.push_front(value);
+        } else if (random() % 4 == 0) {
+            list.compact();
+        }
+
+        ASSERT_EQ(list.length(), model.size());
+        ASSERT_EQ(std::vector<int>(list.begin(), list.end()), std::vector<int>(model.begin(), model.end()));
+        ASSERT_EQ(std::vector<int>(list.rbegin(), list.rend()), std::vector<int>(model.rbegin(), model.rend()));
+        if (not model.empty()) {
+            ASSERT_EQ(list.head()->value, model.front());
+            ASSERT_EQ(list.tail()->value, model.back());
+            ASSERT_EQ(list.at(k % model.size())->value, model[k % model.size()]);
+        }
+    }
+}
+
+template <class Snapshot>
+std::vector<int>
+snapshot_values(const Snapshot& snapshot) {
+    std::vector<int> values;
+    snapshot.for_each([&values](int value) -> void { values.push_back(value); });
+    return values;
+}
+
+TEST(Method, Snapshot_) {
+    std::vector<int> vec(100);
+    std::iota(vec.begin(), vec.end(), 0);
+    DoublyLinkedList<int> list(8, vec.begin(), vec.end());
+    auto snapshot = list.snapshot();
+    list.reset_stats();
+
+    list.push_head(-1);
+    list.push_tail(100);
+    list.insert(50, -2);
+    ASSERT_EQ(list.pop(20), 19);
+    list.pop_head();
+    list.pop_head();
+    list.reverse();
+    list.pop_head();
+
+    ASSERT_EQ(snapshot.length(), 100);
+    ASSERT_EQ(snapshot_values(snapshot), vec);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(snapshot.at(i), i);
+    }
+    // Only the segments of 19, 48 (which -2 follows) and 0 were copied out
+    ASSERT_EQ(list.stats().detached, STATS ? 3 : 0);
+
+    auto reversed = list.snapshot();
+    std::vector<int> values(list.begin(), list.end());
+    list.sort();
+    list.clear();
+    ASSERT_EQ(snapshot_values(reversed), values);
+    ASSERT_EQ(reversed.at(0), 99);
+    ASSERT_EQ(snapshot_values(snapshot), vec);
+}
+
+// Copies throw while fail is set
+struct Fragile {
+    static inline bool fail = false;
+    int value = 0;
+
+    Fragile(void) = default;
+    explicit Fragile(int value) : value(value) {}
+    Fragile(const Fragile& other) : value(other.value) {
+        if (fail) {
+            throw std::runtime_error("copy");
+        }
+    }
+};
+
+// Inserts whose copy throws leave the snapshots as they were
+TEST(Method, Snapshot_Throw) {
+    DoublyLinkedList<Fragile> list(8);
+    for (int i = 0; i < 20; ++i) {
+        list.push_tail(Fragile(i));
+    }
+    auto snapshot = list.snapshot();
+    Fragile value(-1);
+
+    Fragile::fail = true;
+    ASSERT_THROW(list.push_head(value), std::runtime_error);
+    ASSERT_THROW(list.push_tail(value), std::runtime_error);
+    ASSERT_THROW(list.insert(8, value), std::runtime_error);
+    Fragile::fail = false;
+    ASSERT_EQ(list.length(), 20);
+
+    list.pop(8);
+    list.pop(15);
+    list.pop_head();
+    list.insert(7, value);
+    list.clear();
+    std::vector<int> values;
+    snapshot.for_each([&values](const Fragile& fragile) -> void { values.push_back(fragile.value); });
+    std::vector<int> vec(20);
+    std::iota(vec.begin(), vec.end(), 0);
+    ASSERT_EQ(values, vec);
+}
+
+// Snapshots taken while the list changes at random, checked against copies made at the same time
+TEST(Method, Snapshot_Random) {
+    using Snapshot = DoublyLinkedList<int>::Snapshot;
+    DoublyLinkedList<int> list(4);
+    std::deque<int> model;
+    std::vector<std::pair<Snapshot, std::vector<int>>> snapshots;
+    std::mt19937 random(7);
+
+    for (int i = 0; i < 3000; ++i) {
+        size_t k = model.empty() ? 0 : random() % model.size();
+        int op = model.empty() ? random() % 2 : random() % 12;
+        if (op == 0) {
+            list.push_head(i);
+            model.push_front(i);
+        } else if (op == 1) {
+            list.push_tail(i);
+            model.push_back(i);
+        } else if (op == 2) {
+            list.pop_head();
+            model.pop_front();
+        } else if (op == 3) {
+            list.pop_tail();
+            model.pop_back();
+        } else if (op == 4 or op == 5) {
+            list.insert(k, i);
+            model.insert(model.begin() + k, i);
+        } else if (op == 6 or op == 7) {
+            list.pop(k);
+            model.erase(model.begin() + k);
+        } else if (op == 8) {
+            list.reverse();
+            std::reverse(model.begin(), model.end());
+        } else if (op == 9 and random() % 8 == 0) {
+            list.rotate(k);
+            std::rotate(model.begin(), model.begin() + k, model.end());
+        } else if (op == 10 and random() % 8 == 0) {
+            list.move_to_head(list.at(k));
+            int value = model[k];
+            model.erase(model.begin() + k);
+            model.push_front(value);
+        } else if (random() % 16 == 0) {
+            snapshots.emplace_back(list.snapshot(), std::vector<int>(model.begin(), model.end()));
+        }
+        if (i % 100 == 0) {
+            for (const auto& [snapshot, values] : snapshots) {
+                ASSERT_EQ(snapshot_values(snapshot), values);
+            }
+        }
+    }
+
+    ASSERT_GT(snapshots.size(), 10);
+    list.clear();
+    for (const auto& [snapshot, values] : snapshots) {
+        ASSERT_EQ(snapshot_values(snapshot), values);
+        for (size_t k = 0; k < values.size(); k += 7) {
+            ASSERT_EQ(snapshot.at(k), values[k]);
+        }
+    }
+}
+
+TEST(Method, Snapshot_Concurrent) {
+    std::vector<int> vec(10000);
+    std::iota(vec.begin(), vec.end(), 0);
+    DoublyLinkedList<int> list(16, vec.begin(), vec.end());
+    auto snapshot = list.snapshot();
+
+    std::thread reader([&snapshot, &vec]() -> void {
+        for (int i = 0; i < 20; ++i) {
+            ASSERT_EQ(snapshot_values(snapshot), vec);
+        }
+    });
+    std::mt19937 random(11);
+    for (int i = 0; i < 20000; ++i) {
+        if (random() % 2) {
+            list.insert(random() % list.length(), -i);
+        } else {
+            list.pop(random() % list.length());
+        }
+    }
+    reader.join();
+    ASSERT_EQ(snapshot_values(snapshot), vec);
+}
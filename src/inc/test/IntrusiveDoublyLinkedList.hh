@@ -0,0 +1,161 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+#include "../IntrusiveDoublyLinkedList.hh"
+
+struct Item {
+    int value;
+    IntrusiveHook<Item> hook;
+    // A second hook links the same item into a second list
+    IntrusiveHook<Item> other;
+};
+
+using Items = IntrusiveDoublyLinkedList<Item, &Item::hook>;
+
+std::vector<int>
+item_values(const Items& list) {
+    std::vector<int> values;
+    for (const Item& item : list) {
+        values.push_back(item.value);
+    }
+    return values;
+}
+
+TEST(Intrusive, Push_Pop) {
+    std::vector<Item> items(6);
+    Items list(2);
+    for (int i = 0; i < 6; i++) {
+        items[i].value = i;
+        i % 2 ? list.push_tail(items[i]) : list.push_head(items[i]);
+    }
+
+    ASSERT_EQ(item_values(list), std::vector<int>({4, 2, 0, 1, 3, 5}));
+    ASSERT_EQ(list.head(), &items[4]);
+    ASSERT_EQ(list.tail(), &items[5]);
+    ASSERT_EQ(list.head()->hook.prev, nullptr);
+    ASSERT_EQ(list.tail()->hook.next, nullptr);
+
+    ASSERT_EQ(list.pop_head(), &items[4]);
+    ASSERT_EQ(list.pop_tail(), &items[5]);
+    ASSERT_EQ(&list.pop(1), &items[0]);
+    ASSERT_EQ(item_values(list), std::vector<int>({2, 1, 3}));
+    ASSERT_THROW(list.pop(3), std::out_of_range);
+
+    // Popped items can go right back in
+    list.insert(1, items[4]);
+    list.insert(4, items[5]);
+    ASSERT_THROW(list.insert(6, items[0]), std::out_of_range);
+    ASSERT_EQ(item_values(list), std::vector<int>({2, 4, 1, 3, 5}));
+
+    while (not list.empty()) {
+        list.pop_tail();
+    }
+    ASSERT_EQ(list.pop_head(), nullptr);
+    ASSERT_EQ(list.pop_tail(), nullptr);
+    ASSERT_EQ(list.head(), nullptr);
+}
+
+TEST(Intrusive, At_Erase) {
+    std::vector<Item> items(20);
+    Items list(3);
+    for (int i = 0; i < 20; i++) {
+        items[i].value = i;
+        list.push_tail(items[i]);
+    }
+
+    for (uint64_t pos : {0u, 2u, 3u, 17u, 19u}) {
+        ASSERT_EQ(&list.at(pos), &items[pos]);
+    }
+    ASSERT_THROW(static_cast<void>(list.at(20)), std::out_of_range);
+
+    // Head, tail and the middle, through the items themselves
+    for (int i : {0, 19, 7, 8, 12}) {
+        list.erase(items[i]);
+    }
+    ASSERT_EQ(list.length(), 15u);
+    ASSERT_EQ(list.at(6).value, 9);
+    ASSERT_EQ(list.at(14).value, 18);
+    ASSERT_EQ(item_values(list), std::vector<int>({1, 2, 3, 4, 5, 6, 9, 10, 11, 13, 14, 15, 16, 17, 18}));
+
+    list.at(0).value = 100;
+    ASSERT_EQ(items[1].value, 100);
+}
+
+TEST(Intrusive, TwoHooks) {
+    std::vector<Item> items(4);
+    Items by_hook(2);
+    IntrusiveDoublyLinkedList<Item, &Item::other> by_other(2);
+    for (int i = 0; i < 4; i++) {
+        items[i].value = i;
+        by_hook.push_tail(items[i]);
+        by_other.push_head(items[i]);
+    }
+    by_other.erase(items[1]);
+
+    ASSERT_EQ(item_values(by_hook), std::vector<int>({0, 1, 2, 3}));
+    ASSERT_EQ(&by_other.at(1), &items[2]);
+    ASSERT_EQ(by_other.length(), 3u);
+}
+
+TEST(Intrusive, Random) {
+    for (unsigned size : {1u, 2u, 5u, 16u}) {
+        std::vector<Item> items(1000);
+        // Items not in the list
+        std::vector<Item*> spare;
+        for (Item& item : items) {
+            spare.push_back(&item);
+        }
+        Items list(size);
+        list.reserve(items.size());
+        std::deque<Item*> model;
+        std::mt19937 random(size);
+
+        for (int i = 0; i < 4000; i++) {
+            uint64_t k = model.empty() ? 0 : random() % model.size();
+            int op = spare.empty() ? 3 + random() % 5 : random() % 8;
+            if (op < 3) {
+                Item* item = spare.back();
+                spare.pop_back();
+                item->value = i;
+                if (op == 0) {
+                    list.push_tail(*item);
+                    model.push_back(item);
+                } else if (op == 1) {
+                    list.push_head(*item);
+                    model.push_front(item);
+                } else {
+                    k = model.empty() ? 0 : random() % (model.size() + 1);
+                    list.insert(k, *item);
+                    model.insert(model.begin() + k, item);
+                }
+            } else if (model.empty()) {
+                ASSERT_EQ(list.pop_tail(), nullptr);
+            } else if (op == 3) {
+                ASSERT_EQ(list.pop_head(), model.front());
+                spare.push_back(model.front());
+                model.pop_front();
+            } else if (op == 4) {
+                ASSERT_EQ(&list.pop(k), model[k]);
+                spare.push_back(model[k]);
+                model.erase(model.begin() + k);
+            } else if (op == 5) {
+                list.erase(*model[k]);
+                spare.push_back(model[k]);
+                model.erase(model.begin() + k);
+            } else {
+                ASSERT_EQ(&list.at(k), model[k]);
+            }
+            ASSERT_EQ(list.length(), model.size());
+        }
+        std::vector<Item*> visited;
+        for (Item& item : list) {
+            visited.push_back(&item);
+        }
+        ASSERT_EQ(visited, std::vector<Item*>(model.begin(), model.end()));
+        ASSERT_EQ(list.tail(), model.empty() ? nullptr : model.back());
+    }
+}
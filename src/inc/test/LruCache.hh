@@ -0,0 +1,155 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../LruCache.hh"
+
+TEST(Lru, Get_Put) {
+    LruCache<int, std::string> cache(2);
+
+    cache.put(1, "one");
+    cache.put(2, "two");
+    ASSERT_EQ(*cache.get(1), "one");
+    cache.put(3, "three");
+
+    ASSERT_EQ(cache.length(), 2);
+    ASSERT_EQ(cache.get(2), nullptr);
+    ASSERT_EQ(*cache.get(3), "three");
+    ASSERT_EQ(*cache.get(1), "one");
+
+    cache.put(3, "drei");
+    cache.put(4, "four");
+    ASSERT_FALSE(cache.contains(1));
+    ASSERT_EQ(*cache.peek(3), "drei");
+}
+
+TEST(Lru, Erase_) {
+    LruCache<int, int> cache(3);
+
+    cache.put(1, 10);
+    ASSERT_TRUE(cache.erase(1));
+    ASSERT_FALSE(cache.erase(1));
+    ASSERT_TRUE(cache.empty());
+
+    for (int i = 0; i < 5; ++i) {
+        cache.put(i, i * 10);
+    }
+    ASSERT_TRUE(cache.erase(3));
+    cache.put(5, 50);
+    std::vector<int> keys;
+    for (const auto& entry : cache) {
+        keys.push_back(entry.key);
+    }
+    ASSERT_EQ(keys, std::vector<int>({5, 4, 2}));
+}
+
+TEST(Lru, Copy_) {
+    auto cache = std::make_unique<LruCache<int, std::string>>(3);
+    for (int i = 0; i < 4; ++i) {
+        cache->put(i, std::to_string(i));
+    }
+    LruCache<int, std::string> copy(*cache);
+    LruCache<int, std::string> assigned(1);
+    assigned.put(7, "7");
+    assigned = *cache;
+    cache.reset();
+
+    for (LruCache<int, std::string>* c : {&copy, &assigned}) {
+        ASSERT_EQ(c->get(0), nullptr);
+        ASSERT_EQ(*c->get(1), "1");
+        c->put(4, "4");
+        ASSERT_FALSE(c->contains(2));
+        ASSERT_EQ(*c->peek(3), "3");
+        ASSERT_EQ(c->length(), 3);
+    }
+
+    LruCache<int, std::string> moved(std::move(copy));
+    ASSERT_EQ(*moved.get(4), "4");
+    moved = LruCache<int, std::string>(assigned);
+    ASSERT_EQ(*moved.get(1), "1");
+}
+
+TEST(Lru, Copy_Size) {
+    LruCache<int, int, std::hash<int>, uint16_t> cache(20, 3);
+    for (int i = 0; i < 30; ++i) {
+        cache.put(i, i * 10);
+    }
+    LruCache<int, int, std::hash<int>, uint16_t> copy(cache);
+    LruCache<int, int, std::hash<int>, uint16_t> assigned(5, 2);
+    assigned.put(1, 1);
+    assigned = cache;
+
+    for (auto* c : {&copy, &assigned}) {
+        ASSERT_EQ(c->capacity(), 20);
+        ASSERT_FALSE(c->contains(9));
+        ASSERT_EQ(*c->get(10), 100);
+        c->put(30, 300);
+        ASSERT_FALSE(c->contains(11));
+        ASSERT_EQ(c->begin()->key, 30);
+        ASSERT_EQ(c->length(), 20);
+    }
+    ASSERT_TRUE(cache.contains(11));
+}
+
+TEST(Lru, Put_Fill) {
+    LruCache<int, int> cache(1 << 14, 8);
+    for (int i = 0; i < 1 << 14; ++i) {
+        cache.put(i, i);
+        // New keys go in front without moving the anchors of the list
+        ASSERT_EQ(cache.stats().shifted, 0);
+    }
+    ASSERT_EQ(cache.length(), 1 << 14);
+    ASSERT_EQ(cache.begin()->key, (1 << 14) - 1);
+    ASSERT_EQ(*cache.get(0), 0);
+}
+
+// Compared against the std::list + std::unordered_map cache this replaces
+TEST(Lru, Random) {
+    const uint64_t CAPACITY = 100;
+    LruCache<uint64_t, uint64_t> cache(CAPACITY, 8);
+    std::list<std::pair<uint64_t, uint64_t>> order;
+    std::unordered_map<uint64_t, decltype(order)::iterator> index;
+    std::mt19937_64 random(1);
+
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t key = random() % 300, op = random() % 8;
+        auto it = index.find(key);
+        if (op == 0) {
+            ASSERT_EQ(cache.erase(key), it != index.end());
+            if (it != index.end()) {
+                order.erase(it->second);
+                index.erase(it);
+            }
+        } else if (op < 4) {
+            uint64_t* value = cache.get(key);
+            ASSERT_EQ(value != nullptr, it != index.end());
+            if (value != nullptr) {
+                ASSERT_EQ(*value, it->second->second);
+                order.splice(order.begin(), order, it->second);
+            }
+        } else {
+            cache.put(key, i);
+            if (it != index.end()) {
+                order.erase(it->second);
+            } else if (order.size() == CAPACITY) {
+                index.erase(order.back().first);
+                order.pop_back();
+            }
+            order.emplace_front(key, i);
+            index[key] = order.begin();
+        }
+        ASSERT_EQ(cache.length(), order.size());
+    }
+
+    auto it = order.begin();
+    for (const auto& entry : cache) {
+        ASSERT_EQ(entry.key, it->first);
+        ASSERT_EQ(entry.value, it->second);
+        ++it;
+    }
+}
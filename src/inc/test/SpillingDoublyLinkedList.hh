@@ -0,0 +1,107 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include "../SpillingDoublyLinkedList.hh"
+
+TEST(Spill, Push_Pop) {
+    // Two resident segments of 4 values
+    SpillingDoublyLinkedList<int> list(4, 2 * 4 * sizeof(int));
+
+    for (int i = 0; i < 40; ++i) {
+        list.push_tail(i);
+        ASSERT_LE(list.resident(), list.capacity());
+    }
+    ASSERT_EQ(list.length(), 40u);
+    ASSERT_EQ(list.capacity(), 2u);
+    ASSERT_EQ(list.stats().writes, 8u);
+
+    for (int i = 39; i >= 0; --i) {
+        ASSERT_EQ(list.pop_tail(), i);
+    }
+    ASSERT_TRUE(list.empty());
+    ASSERT_EQ(list.pop_tail(), 0);
+
+    std::stringstream ss;
+    list.push_tail(1);
+    list.push_tail(2);
+    ss << list;
+    ASSERT_EQ(ss.str(), "head -> 1 <-> 2 <- tail");
+}
+
+TEST(Spill, At_Set) {
+    SpillingDoublyLinkedList<uint64_t> list(8, 1024);
+
+    for (uint64_t i = 0; i < 1000; ++i) {
+        list.push_tail(i * i);
+    }
+    for (uint64_t pos : {999u, 0u, 500u, 7u, 8u, 640u}) {
+        ASSERT_EQ(list.at(pos), pos * pos);
+    }
+    ASSERT_THROW(static_cast<void>(list.at(1000)), std::out_of_range);
+
+    // Dirty segments are written back once evicted
+    for (uint64_t pos = 0; pos < 1000; pos += 3) {
+        list.set(pos, pos);
+    }
+    for (uint64_t pos = 0; pos < 1000; ++pos) {
+        ASSERT_EQ(list.at(pos), pos % 3 ? pos * pos : pos);
+    }
+    ASSERT_LE(list.resident(), list.capacity());
+}
+
+TEST(Spill, Sequential_Batched) {
+    SpillingDoublyLinkedList<int> list(64, 64 * 64 * sizeof(int));
+    std::vector<int> vec;
+    for (int i = 0; i < 64 * 1000; ++i) {
+        list.push_tail(i);
+        vec.push_back(i);
+    }
+    uint64_t reads = list.stats().reads;
+
+    std::vector<int> visited;
+    list.for_each([&visited](int value) { visited.push_back(value); });
+    ASSERT_EQ(visited, vec);
+    // Up to readahead segments per read
+    ASSERT_LE(list.stats().reads - reads, 1000 / list.readahead + 1);
+
+    reads = list.stats().reads;
+    ASSERT_EQ(std::vector<int>(list.begin(), list.end()), vec);
+    ASSERT_LT(list.stats().reads - reads, 1000u / 4);
+}
+
+TEST(Spill, Random) {
+    // A clock of a few and of many resident segments
+    for (auto [size, segments] : {std::pair(1u, 3u), std::pair(3u, 3u), std::pair(16u, 3u), std::pair(3u, 40u)}) {
+        SpillingDoublyLinkedList<int64_t> list(size, size * segments * sizeof(int64_t));
+        std::vector<int64_t> vec;
+        std::mt19937_64 random(size + segments);
+        for (int i = 0; i < 5000; ++i) {
+            int op = random() % 10;
+            if (op < 5) {
+                list.push_tail(i);
+                vec.push_back(i);
+            } else if (op < 7) {
+                ASSERT_EQ(list.pop_tail(), vec.empty() ? 0 : vec.back());
+                if (not vec.empty()) {
+                    vec.pop_back();
+                }
+            } else if (op < 9 and not vec.empty()) {
+                uint64_t pos = random() % vec.size();
+                list.set(pos, -i);
+                vec[pos] = -i;
+            } else if (not vec.empty()) {
+                uint64_t pos = random() % vec.size();
+                ASSERT_EQ(list.at(pos), vec[pos]);
+            }
+            ASSERT_EQ(list.length(), vec.size());
+            ASSERT_LE(list.resident(), list.capacity());
+        }
+        ASSERT_EQ(std::vector<int64_t>(list.begin(), list.end()), vec);
+        list.clear();
+        ASSERT_TRUE(list.empty());
+    }
+}
@@ -1,4 +1,9 @@
 #include "inc/test/DoublyLinkedList.hh"
+#include "inc/test/BoundedDoublyLinkedList.hh"
+#include "inc/test/LruCache.hh"
+#include "inc/test/CompressedDoublyLinkedList.hh"
+#include "inc/test/SpillingDoublyLinkedList.hh"
+#include "inc/test/IntrusiveDoublyLinkedList.hh"
 
 int
 main(int argc, char** argv) {